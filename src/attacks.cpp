@@ -9,6 +9,8 @@ using namespace JACEA;
 Bitboard JACEA::pawn_attacks[2][64];
 Bitboard JACEA::knight_attacks[64];
 Bitboard JACEA::king_attacks[64];
+Bitboard JACEA::between_squares[64][64];
+Bitboard JACEA::line_squares[64][64];
 
 int JACEA::bishop_relevant_bits[64];
 int JACEA::rook_relevant_bits[64];
@@ -149,7 +151,12 @@ void JACEA::init_bishop_magic_attack()
         for (int i = 0; i < occ_indicies; i++)
         {
             Bitboard occ = set_occupancy(i, bits_count, attack_mask);
-            int magic_index = (occ * bishop_magics[square]) >> (64 - bishop_relevant_bits[square]);
+#ifdef USE_PEXT
+            // set_occupancy deposits the bits of i into the mask, so pext gives i back
+            const int magic_index = i;
+#else
+            const int magic_index = (occ * bishop_magics[square]) >> (64 - bishop_relevant_bits[square]);
+#endif
 
             bishop_attacks[square][magic_index] = generate_bishop_attacks(square, occ);
         }
@@ -169,13 +176,48 @@ void JACEA::init_rook_magic_attack()
         for (int i = 0; i < occ_indicies; i++)
         {
             Bitboard occ = set_occupancy(i, bits_count, attack_mask);
-            int magic_index = (occ * rook_magics[square]) >> (64 - rook_relevant_bits[square]);
+#ifdef USE_PEXT
+            // set_occupancy deposits the bits of i into the mask, so pext gives i back
+            const int magic_index = i;
+#else
+            const int magic_index = (occ * rook_magics[square]) >> (64 - rook_relevant_bits[square]);
+#endif
 
             rook_attacks[square][magic_index] = generate_rook_attacks(square, occ);
         }
     }
 }
 
+void JACEA::init_between_squares()
+{
+    for (Square from = 0; from < 64; from++)
+    {
+        for (Square to = 0; to < 64; to++)
+        {
+            Bitboard from_bb = 0ULL;
+            Bitboard to_bb = 0ULL;
+            set_bit(from_bb, from);
+            set_bit(to_bb, to);
+
+            if (get_rook_attacks(from, 0ULL) & to_bb)
+            {
+                between_squares[from][to] = get_rook_attacks(from, to_bb) & get_rook_attacks(to, from_bb);
+                line_squares[from][to] = (get_rook_attacks(from, 0ULL) & get_rook_attacks(to, 0ULL)) | from_bb | to_bb;
+            }
+            else if (get_bishop_attacks(from, 0ULL) & to_bb)
+            {
+                between_squares[from][to] = get_bishop_attacks(from, to_bb) & get_bishop_attacks(to, from_bb);
+                line_squares[from][to] = (get_bishop_attacks(from, 0ULL) & get_bishop_attacks(to, 0ULL)) | from_bb | to_bb;
+            }
+            else
+            {
+                between_squares[from][to] = 0ULL;
+                line_squares[from][to] = 0ULL;
+            }
+        }
+    }
+}
+
 void JACEA::init_magic_numbers()
 {
     for (Square i = 0; i < 64; i++)
@@ -357,12 +399,10 @@ Bitboard JACEA::set_occupancy(const int index, const int bits_in_mask, Bitboard
 
     for (int count = 0; count < bits_in_mask; count++)
     {
-        const Square square = get_firstlsb_index(attack_mask);
+        const Square square = pop_lsb(attack_mask);
 
         if (get_bit(index, count))
             set_bit(occupancy, square);
-
-        pop_bit(attack_mask, square);
     }
 
     return occupancy;
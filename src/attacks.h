@@ -8,6 +8,11 @@ namespace JACEA
     extern Bitboard knight_attacks[64];
     extern Bitboard king_attacks[64];
 
+    // [from][to] squares strictly between two aligned squares, 0 if not on a common line
+    extern Bitboard between_squares[64][64];
+    // [from][to] the whole rank, file or diagonal through both squares, 0 if not on a common line
+    extern Bitboard line_squares[64][64];
+
     // Used for magic bitboard shift
     extern int bishop_relevant_bits[64];
     extern int rook_relevant_bits[64];
@@ -41,6 +46,9 @@ namespace JACEA
     void init_bishop_magic_attack();
     void init_rook_magic_attack();
 
+    // Init between and line squares, needs the magic attacks
+    void init_between_squares();
+
     u64 find_magic_number_bishop(const Square square, const int relevant_bits);
     u64 find_magic_number_rook(const Square square, const int relevant_bits);
 
@@ -50,22 +58,31 @@ namespace JACEA
 
     Bitboard set_occupancy(const int index, const int bits_in_mask, Bitboard attack_mask);
 
+    // With USE_PEXT the tables are indexed by pext of the mask instead of the magic product
     static inline Bitboard get_bishop_attacks(const Square square, u64 occupancy)
     {
         assert(0 <= square && square < 64);
+#ifdef USE_PEXT
+        return bishop_attacks[square][pext(occupancy, bishop_mask[square])];
+#else
         occupancy &= bishop_mask[square];
         occupancy *= bishop_magics[square];
         occupancy >>= 64ull - bishop_relevant_bits[square];
         return bishop_attacks[square][occupancy];
+#endif
     }
 
     static inline Bitboard get_rook_attacks(const Square square, u64 occupancy)
     {
         assert(0 <= square && square < 64);
+#ifdef USE_PEXT
+        return rook_attacks[square][pext(occupancy, rook_mask[square])];
+#else
         occupancy &= rook_mask[square];
         occupancy *= rook_magics[square];
         occupancy >>= 64ull - rook_relevant_bits[square];
         return rook_attacks[square][occupancy];
+#endif
     }
 
     static inline Bitboard get_queen_attacks(const Square square, u64 occupancy)
@@ -1,9 +1,10 @@
 #pragma once
 
 #include <assert.h>
+#include <cstdint>
 #include <string>
-#include <intrin.h>
 #include <bit>
+#include "bitops.h"
 
 namespace JACEA
 {
@@ -23,11 +24,10 @@ namespace JACEA
         DOWN_LEFT
     };
 
-    typedef int Square;
+    typedef uint8_t Square;
 
-    enum eSquare : int
+    enum eSquare : uint8_t
     {
-        no_sq = -1,
         a8 = 0,
         b8,
         c8,
@@ -91,7 +91,8 @@ namespace JACEA
         e1,
         f1,
         g1,
-        h1
+        h1,
+        no_sq
     };
 
     const int to_nnue_square[64] = {
@@ -120,8 +121,10 @@ namespace JACEA
     constexpr Bitboard NOT_G_FILE = 13816973012072644543ULL;
     constexpr Bitboard NOT_H_FILE = 9187201950435737471ULL;
     constexpr Bitboard NOT_GH_FILE = NOT_G_FILE & NOT_H_FILE;
+    constexpr Bitboard FIRST_RANK = 18374686479671623680ULL;
     constexpr Bitboard SECOND_RANK = 71776119061217280ULL;
     constexpr Bitboard SEVENTH_RANK = 65280ULL;
+    constexpr Bitboard EIGHTH_RANK = 255ULL;
     constexpr Bitboard WHITE_QUEEN_CASTLE = 1008806316530991104ULL;
     constexpr Bitboard WHITE_KING_CASTLE = 6917529027641081856ULL;
     constexpr Bitboard BLACK_QUEEN_CASTLE = 14ULL;
@@ -177,11 +180,5 @@ namespace JACEA
         }
     }
 
-    inline int get_firstlsb_index(const Bitboard bb)
-    {
-        assert(bb);
-        return pop_count((bb & -bb) - 1);
-    }
-
     void print_bitboard(const Bitboard bb);
 }
\ No newline at end of file
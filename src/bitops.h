@@ -0,0 +1,74 @@
+#pragma once
+
+#include <assert.h>
+#include <bit>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#if defined(USE_PEXT)
+#include <immintrin.h>
+#endif
+
+/**
+ *  Bit scans and extraction used to walk bitboards. Each compiler gets its own intrinsic so
+ *  that with BMI enabled (-mbmi/-mlzcnt, or /arch:AVX2 on MSVC) they become a single
+ *  tzcnt, lzcnt or blsr.
+ */
+namespace JACEA
+{
+    // Index of the least significant set bit, bb must not be empty
+    inline int lsb(const unsigned long long bb)
+    {
+        assert(bb);
+#if defined(__GNUC__) || defined(__clang__)
+        return __builtin_ctzll(bb);
+#elif defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward64(&index, bb);
+        return int(index);
+#else
+        return std::countr_zero(bb);
+#endif
+    }
+
+    // Index of the most significant set bit, bb must not be empty
+    inline int msb(const unsigned long long bb)
+    {
+        assert(bb);
+#if defined(__GNUC__) || defined(__clang__)
+        return 63 ^ __builtin_clzll(bb);
+#elif defined(_MSC_VER)
+        unsigned long index;
+        _BitScanReverse64(&index, bb);
+        return int(index);
+#else
+        return 63 ^ std::countl_zero(bb);
+#endif
+    }
+
+    // Returns the least significant set bit and clears it from bb
+    inline int pop_lsb(unsigned long long &bb)
+    {
+        const int index = lsb(bb);
+        bb &= bb - 1;
+        return index;
+    }
+
+    // Gathers the bits of bb selected by mask into the low bits of the result
+    inline unsigned long long pext(const unsigned long long bb, unsigned long long mask)
+    {
+#if defined(USE_PEXT)
+        return _pext_u64(bb, mask);
+#else
+        unsigned long long result = 0;
+        for (unsigned long long bit = 1; mask; bit <<= 1)
+        {
+            if (bb & mask & -mask)
+                result |= bit;
+            mask &= mask - 1;
+        }
+        return result;
+#endif
+    }
+}
@@ -0,0 +1,36 @@
+#include "jacea_nnue.hpp"
+
+#ifdef NNUE_EMBEDDED_FILE_PATH
+
+// The default net is pulled into read-only data by the assembler, incbin style.
+// The 63 byte skip lines the feature transformer (file offset 193) up on a
+// 64 byte boundary so nnue_init_data can use it without copying.
+#if defined(__APPLE__)
+#define NNUE_EMBED_SECTION ".const_data"
+#define NNUE_EMBED_SYMBOL(name) "_" #name
+#else
+#define NNUE_EMBED_SECTION ".section .rodata"
+#define NNUE_EMBED_SYMBOL(name) #name
+#endif
+
+__asm__(
+    NNUE_EMBED_SECTION "\n"
+    ".balign 64\n"
+    ".skip 63\n"
+    ".globl " NNUE_EMBED_SYMBOL(jacea_embedded_nnue) "\n"
+    NNUE_EMBED_SYMBOL(jacea_embedded_nnue) ":\n"
+    ".incbin \"" NNUE_EMBEDDED_FILE_PATH "\"\n"
+    ".globl " NNUE_EMBED_SYMBOL(jacea_embedded_nnue_end) "\n"
+    NNUE_EMBED_SYMBOL(jacea_embedded_nnue_end) ":\n"
+    ".byte 0\n"
+    ".text\n");
+
+extern "C" const unsigned char jacea_embedded_nnue[];
+extern "C" const unsigned char jacea_embedded_nnue_end[];
+
+void JACEA::load_embedded_nnue()
+{
+    nnue_init_data(jacea_embedded_nnue, static_cast<size_t>(jacea_embedded_nnue_end - jacea_embedded_nnue));
+}
+
+#endif
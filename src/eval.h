@@ -50,9 +50,7 @@ namespace JACEA
 
     static inline int evaluation(const Position &pos)
     {
-        int pieces[33];
-        int squares[33];
-        int nnue_score = evaluate_nnue(pos, pieces, squares);
+        int nnue_score = evaluate_nnue(pos);
         return nnue_score * std::max((100 - pos.get_fifty()), 0) / 100;
     }
 
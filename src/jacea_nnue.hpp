@@ -2,43 +2,50 @@
 
 #include "position.h"
 #include "nnue.h"
+#include <span>
+#include <vector>
+#include <string>
+#include <filesystem>
 
 namespace JACEA
 {
-    static inline void nnue_input(const Position &pos, int *out_piece, int *out_squares)
+    // Loads a net, going through the mapped weight image when the build configures one
+    static inline void load_nnue(const std::string &nnue_file_path)
     {
-        int i = 2;
-        for (Square sq = 0; sq < 64; sq++)
-        {
-            Piece piece = pos.get_piece_on_square(sq);
-            if (piece == None)
-                continue;
+        const std::string path = std::filesystem::absolute(nnue_file_path).generic_string();
+#ifdef NNUE_CACHE_FILE_PATH
+        nnue_init_cached(path.c_str(), std::filesystem::absolute(NNUE_CACHE_FILE_PATH).generic_string().c_str());
+#else
+        nnue_init(path.c_str());
+#endif
+    }
 
-            if (piece == K)
-            {
-                out_piece[0] = to_nnue_piece[piece];
-                out_squares[0] = to_nnue_square[sq];
-            }
-            else if (piece == k)
-            {
-                out_piece[1] = to_nnue_piece[piece];
-                out_squares[1] = to_nnue_square[sq];
-            }
-            else
-            {
-                out_piece[i] = to_nnue_piece[piece];
-                out_squares[i] = to_nnue_square[sq];
-                i++;
-            }
-        }
-        out_piece[i] = 0;
-        out_squares[i] = 0;
+#ifdef NNUE_EMBEDDED_FILE_PATH
+    // Loads the net compiled into the binary (embedded_nnue.cpp)
+    void load_embedded_nnue();
+
+#endif
+    // Position keeps its pieces in nnue order (kings first, 0 terminated) so they can be passed straight through
+    static inline int evaluate_nnue(const Position &pos)
+    {
+        return nnue_evaluate(pos.get_side(), pos.get_nnue_pieces(), pos.get_nnue_squares());
     }
 
-    static inline int evaluate_nnue(const Position &pos, int *pieces, int *squares)
+    // Raw network scores for many positions in one call, scores[i] belongs to positions[i]
+    static inline void evaluate_nnue_batch(std::span<const Position> positions, std::span<int> scores)
     {
-        nnue_input(pos, pieces, squares);
-        int score = nnue_evaluate(pos.get_side(), pieces, squares);
-        return score;
+        assert(scores.size() >= positions.size());
+
+        std::vector<int> players(positions.size());
+        std::vector<const int *> pieces(positions.size());
+        std::vector<const int *> squares(positions.size());
+        for (size_t i = 0; i < positions.size(); i++)
+        {
+            players[i] = positions[i].get_side();
+            pieces[i] = positions[i].get_nnue_pieces();
+            squares[i] = positions[i].get_nnue_squares();
+        }
+
+        nnue_evaluate_batch(static_cast<int>(positions.size()), players.data(), pieces.data(), squares.data(), scores.data());
     }
 }
\ No newline at end of file
@@ -9,12 +9,15 @@
 #include <ctime>
 #include "eval.h"
 #include "search.h"
+#include "proofsearch.h"
 #include "types.h"
 #include "transpositiontable.h"
-#include "tbprobe.h"
+#include "tablebase.h"
 #include <filesystem>
 #include "utility.h"
 #include <future>
+#include <fstream>
+#include <memory>
 
 using namespace JACEA;
 
@@ -28,7 +31,7 @@ unsigned long long perft(JACEA::Position &pos, int depth)
 	generate_moves(pos, ml);
 	for (int i = 0; i < ml.size; i++)
 	{
-		if (pos.make_move(ml.moves[i].move, MoveType::ALL))
+		if (pos.make_move(ml.moves[i], MoveType::ALL))
 		{
 			nodes += perft(pos, depth - 1);
 			pos.take_move();
@@ -49,9 +52,9 @@ unsigned long long perft_verbose(JACEA::Position &pos, int depth)
 	for (int i = 0; i < ml.size; i++)
 	{
 		u64 node = 0;
-		if (pos.make_move(ml.moves[i].move, MoveType::ALL))
+		if (pos.make_move(ml.moves[i], MoveType::ALL))
 		{
-			std::cout << square_to_coordinate[get_from_square(ml.moves[i].move)] << square_to_coordinate[get_to_square(ml.moves[i].move)] << " = " << (node = perft(pos, depth - 1)) << std::endl;
+			std::cout << square_to_coordinate[get_from_square(ml.moves[i])] << square_to_coordinate[get_to_square(ml.moves[i])] << " = " << (node = perft(pos, depth - 1)) << std::endl;
 			nodes += node;
 			pos.take_move();
 		}
@@ -59,6 +62,96 @@ unsigned long long perft_verbose(JACEA::Position &pos, int depth)
 	return nodes;
 }
 
+// Scores every FEN of a file (one per line) with the raw network, printing one score per line
+void eval_batch_file(const std::string &path)
+{
+	// A Position carries its search tables, so the chunks stay small and the positions are reused
+	constexpr size_t chunk_size = 256;
+
+	std::ifstream fens(path);
+	if (!fens)
+	{
+		std::cerr << "Could not open " << path << std::endl;
+		return;
+	}
+
+	std::vector<JACEA::Position> positions(chunk_size);
+	std::vector<int> scores(chunk_size);
+	size_t count = 0;
+	u64 total = 0;
+	auto start_time = get_time_ms();
+
+	auto flush = [&]()
+	{
+		JACEA::evaluate_nnue_batch(std::span(positions.data(), count), scores);
+		for (size_t i = 0; i < count; i++)
+			std::cout << scores[i] << "\n";
+		total += count;
+		count = 0;
+	};
+
+	std::string fen;
+	while (std::getline(fens, fen))
+	{
+		if (fen.empty())
+			continue;
+		positions[count++].init_from_fen(fen);
+		if (count == chunk_size)
+			flush();
+	}
+	flush();
+
+	auto duration = get_time_ms() - start_time;
+	std::cerr << "Positions \t: " << total << std::endl;
+	std::cerr << "Time (s) \t: " << duration / 1000.0 << std::endl;
+}
+
+// Perft and fixed depth searches over a fixed set of positions, to compare builds (e.g. COPY_MAKE)
+void bench(TranspositionTable &tt, int depth)
+{
+	const std::string fens[] = {
+		"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+		"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+		"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+		"r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+		"rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+		"r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10"};
+	constexpr int perft_depth = 4;
+
+	// Large with COPY_MAKE, keep it off the stack
+	auto pos = std::make_unique<JACEA::Position>();
+	u64 perft_nodes = 0, search_nodes = 0;
+	long long perft_time = 0, search_time = 0;
+
+	for (const auto &fen : fens)
+	{
+		pos->init_from_fen(fen);
+		auto start_time = get_time_ms();
+		perft_nodes += perft(*pos, perft_depth);
+		perft_time += get_time_ms() - start_time;
+
+		// Single threaded so the node counts can be compared between builds
+		JACEA::UCISettings uci;
+		uci.deterministic = true;
+		tt.clear_table();
+		start_time = get_time_ms();
+		uci.time_to_stop = start_time + 60 * 60 * 1000;
+		search(*pos, tt, uci, depth);
+		search_time += get_time_ms() - start_time;
+		search_nodes += uci.total_nodes;
+	}
+
+#ifdef COPY_MAKE
+	std::cout << "Make mode \t: copy-make" << std::endl;
+#else
+	std::cout << "Make mode \t: make/unmake" << std::endl;
+#endif
+	std::cout << "Perft nodes \t: " << perft_nodes << std::endl;
+	std::cout << "Perft nodes/s \t: " << perft_nodes * 1000 / std::max(perft_time, 1LL) << std::endl;
+	std::cout << "Search nodes \t: " << search_nodes << std::endl;
+	std::cout << "Search nodes/s \t: " << search_nodes * 1000 / std::max(search_time, 1LL) << std::endl;
+}
+
 int main(void)
 {
 	/**
@@ -74,10 +167,15 @@ int main(void)
 	init_magic_numbers();
 	init_bishop_magic_attack();
 	init_rook_magic_attack();
+	init_between_squares();
 	init_zobrist_keys();
 	init_pst();
 	init_mvv_lva();
-	nnue_init(std::filesystem::absolute(NNUE_FILE_PATH).generic_string().c_str());
+#ifdef NNUE_EMBEDDED_FILE_PATH
+	load_embedded_nnue();
+#else
+	load_nnue(NNUE_FILE_PATH);
+#endif
     tb_init(std::filesystem::absolute(SYZYGY_PATH).generic_string().c_str());
 
 	const size_t default_hash_size_mb = 64;
@@ -102,7 +200,7 @@ int main(void)
 		while (tokenizer >> token) {
 			if (token == "setoption")
 			{
-				parse_setoption(transposition_table, tokenizer);
+				parse_setoption(transposition_table, uci_settings, tokenizer);
 			}
 			else if (token == "debug") 
 			{
@@ -122,7 +220,7 @@ int main(void)
 			}
 			else if (token == "ponderhit")
 			{
-				std::cerr << "Pondering currently not supported" << std::endl;
+				ponderhit(uci_settings);
 			}
 			else if (token == "ucinewgame")
 			{
@@ -135,7 +233,14 @@ int main(void)
 				std::cout << std::endl;
 				std::cout << "option name Hash type spin default " << default_hash_size_mb << " min 0" << std::endl;
 				std::cout << "option name SyzygyPath type string default <empty>" << std::endl;
+				std::cout << "option name SyzygyProbeDepth type spin default " << uci_settings.syzygy_probe_depth << " min 1 max 100" << std::endl;
+				std::cout << "option name SyzygyProbeLimit type spin default " << uci_settings.syzygy_probe_limit << " min 0 max 7" << std::endl;
 				std::cout << "option name NNUEPath type string default <empty>" << std::endl;
+				std::cout << "option name MultiPV type spin default 1 min 1 max 256" << std::endl;
+				std::cout << "option name Ponder type check default false" << std::endl;
+				std::cout << "option name Move Overhead type spin default 100 min 0 max 5000" << std::endl;
+				std::cout << "option name Threads type spin default " << uci_settings.threads << " min 1 max 256" << std::endl;
+				std::cout << "option name Deterministic type check default false" << std::endl;
 				std::cout << "uciok" << std::endl;
 			}
 			else if (token == "isready")
@@ -145,6 +250,9 @@ int main(void)
 			else if (token == "position")
 			{
 				parse_position(pos, tokenizer);
+				// Entries from the last search would change the next one, a repeated go keeps the table
+				if (uci_settings.deterministic)
+					transposition_table.clear_table();
 			}
 			else if (token == "go")
 			{
@@ -160,6 +268,28 @@ int main(void)
 					parse_go(pos, transposition_table, uci_settings, local_tokenizer);
 				});
 			}
+			else if (token == "prove")
+			{
+				// prove [nodes <n>] [hash <mb>], solves the current position with proof-number search
+				u64 max_nodes = 10000000;
+				size_t table_mb = default_hash_size_mb;
+				while (tokenizer >> token)
+				{
+					if (token == "nodes" && tokenizer >> token)
+						max_nodes = std::stoull(token);
+					else if (token == "hash" && tokenizer >> token)
+						table_mb = std::stoul(token);
+				}
+
+				if (search_future.valid())
+				{
+					search_future.wait();
+				}
+				uci_settings.stop = false;
+				search_future = std::async(std::launch::async, [&, max_nodes, table_mb]() {
+					prove(pos, uci_settings, max_nodes, table_mb);
+				});
+			}
 			else if (token == "quit")
 			{
 				uci_settings.stop = true;
@@ -172,21 +302,9 @@ int main(void)
 			else if (token == "p")
 			{
 				pos.print();
-				std::cout << "Turn (0=w,1=b): " << pos.get_side() << std::endl;
+				std::cout << "Turn (0=w,1=b): " << int(pos.get_side()) << std::endl;
 				std::cout << "Evaluation: " << std::dec << evaluation(pos) << std::endl;
-				unsigned res = tb_probe_root(bswap64(pos.get_occupancy_board(WHITE)),
-											bswap64(pos.get_occupancy_board(BLACK)),
-											bswap64(pos.get_piece_board(k) | pos.get_piece_board(K)),
-											bswap64(pos.get_piece_board(q) | pos.get_piece_board(Q)),
-											bswap64(pos.get_piece_board(r) | pos.get_piece_board(R)),
-											bswap64(pos.get_piece_board(b) | pos.get_piece_board(B)),
-											bswap64(pos.get_piece_board(n) | pos.get_piece_board(N)),
-											bswap64(pos.get_piece_board(p) | pos.get_piece_board(P)),
-											pos.get_fifty(),
-											pos.get_castling_perms(),
-											pos.get_enpassant_square(),
-											pos.get_side() ^ 1,
-											nullptr);
+				unsigned res = probe_root(pos, nullptr);
 				if (res != TB_RESULT_FAILED)
 				{
 					unsigned wdl = TB_GET_WDL(res);
@@ -200,6 +318,19 @@ int main(void)
 					std::cout << "TB Probe: " << wdl_to_str[wdl] << std::endl;
 				}
 			}
+			else if (token == "evalbatch")
+			{
+				std::string path;
+				tokenizer >> path;
+				eval_batch_file(path);
+			}
+			else if (token == "bench")
+			{
+				int bench_depth = 8;
+				if (tokenizer >> token)
+					bench_depth = std::stoi(token);
+				bench(transposition_table, bench_depth);
+			}
 			else if (token == "perft")
 			{
 				int perft_depth;
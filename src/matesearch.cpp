@@ -0,0 +1,183 @@
+#include "matesearch.h"
+#include "movegenerator.h"
+#include "search.h"
+#include "utility.h"
+#include <algorithm>
+#include <iostream>
+#include <unordered_map>
+
+using namespace JACEA;
+
+// Bounds the memory of the refutation table, it starts over once full
+static constexpr size_t max_refuted_positions = 1 << 20;
+
+struct MateSearch
+{
+    explicit MateSearch(UCISettings &uci) : uci(uci) {}
+
+    UCISettings &uci;
+    u64 nodes = 0;
+    // Attacker positions with no mate in up to the stored number of moves, kept across iterations
+    std::unordered_map<u64, int> refuted;
+};
+
+static inline bool stopped(MateSearch &ms)
+{
+    UCISettings &uci = ms.uci;
+    if ((++ms.nodes & 1023) == 0)
+    {
+        if (uci.node_limit && ms.nodes >= uci.node_limit)
+            uci.stop = true;
+        if (!uci.ponder && get_time_ms() > uci.time_to_stop)
+            uci.stop = true;
+    }
+    return uci.stop;
+}
+
+static bool defend(MateSearch &ms, Position &pos, int moves, Move *pv, int &pv_length);
+
+// True when the side to move mates in at most moves moves giving check every time
+static bool attack(MateSearch &ms, Position &pos, const int moves, Move *pv, int &pv_length)
+{
+    if (stopped(ms))
+        return false;
+
+    const auto refuted = ms.refuted.find(pos.get_key());
+    if (refuted != ms.refuted.end() && refuted->second >= moves)
+        return false;
+
+    MoveList ml;
+    generate_moves(pos, ml);
+    Move line[max_game_depth];
+    int line_length = 0;
+    for (int i = 0; i < ml.size; i++)
+    {
+        const Move move = pick_move(ml, i);
+        if (!pos.make_move(move, MoveType::ALL))
+            continue;
+
+        const bool mates = pos.in_check() && defend(ms, pos, moves, line, line_length);
+        pos.take_move();
+
+        if (mates)
+        {
+            pv[0] = move;
+            std::copy(line, line + line_length, pv + 1);
+            pv_length = line_length + 1;
+            return true;
+        }
+        if (ms.uci.stop)
+            return false;
+    }
+
+    if (ms.refuted.size() >= max_refuted_positions)
+        ms.refuted.clear();
+    int &refuted_moves = ms.refuted[pos.get_key()];
+    refuted_moves = std::max(refuted_moves, moves);
+    return false;
+}
+
+// True when every evasion of the side to move, which is in check, still gets mated. moves counts
+// the attacker's move that gave the check
+static bool defend(MateSearch &ms, Position &pos, const int moves, Move *pv, int &pv_length)
+{
+    if (stopped(ms))
+        return false;
+
+    MoveList ml;
+    generate_moves<GenType::EVASIONS>(pos, ml);
+    Move line[max_game_depth];
+    int line_length = 0;
+    pv_length = 0;
+    for (int i = 0; i < ml.size; i++)
+    {
+        const Move move = pick_move(ml, i);
+        if (!pos.make_move(move, MoveType::ALL))
+            continue;
+
+        const bool mated = moves > 1 && attack(ms, pos, moves - 1, line, line_length);
+        pos.take_move();
+
+        if (!mated)
+            return false;
+
+        // Show the defence that holds out longest
+        if (line_length + 1 > pv_length)
+        {
+            pv[0] = move;
+            std::copy(line, line + line_length, pv + 1);
+            pv_length = line_length + 1;
+        }
+    }
+
+    // No evasion at all is mate
+    return true;
+}
+
+bool JACEA::search_mate(Position &pos, UCISettings &uci, int moves)
+{
+    const auto start_time = get_time_ms();
+    MateSearch ms(uci);
+    Move pv[max_game_depth];
+    int pv_length = 0;
+    uci.total_nodes = 0;
+
+    // Both sides' moves have to fit in the position's per ply tables
+    moves = std::min(moves, max_game_depth / 2 - 1);
+    for (int n = 1; n <= moves; n++)
+    {
+        const bool found = attack(ms, pos, n, pv, pv_length);
+        uci.total_nodes = ms.nodes;
+        const long long elapsed = get_time_ms() - start_time;
+
+        if (found)
+        {
+            printf("info depth %d score mate %d nodes %llu time %lld pv ", 2 * n - 1, n, ms.nodes, elapsed);
+            for (int i = 0; i < pv_length; i++)
+            {
+                print_move(pv[i]);
+                std::cout << " ";
+            }
+            std::cout << std::endl;
+
+            std::cout << "bestmove ";
+            print_move(pv[0]);
+            if (pv_length > 1)
+            {
+                std::cout << " ponder ";
+                print_move(pv[1]);
+            }
+            std::cout << std::endl;
+            return true;
+        }
+        if (uci.stop)
+            break;
+        printf("info depth %d nodes %llu time %lld\n", 2 * n - 1, ms.nodes, elapsed);
+    }
+
+    if (!uci.stop)
+    {
+        std::cout << "info string no mate in " << moves << " found" << std::endl;
+        return false;
+    }
+
+    // Stopped before anything was proven, any legal move will do
+    MoveList ml;
+    generate_moves(pos, ml);
+    Move best_move = 0;
+    for (int i = 0; i < ml.size && !best_move; i++)
+    {
+        if (pos.make_move(ml.moves[i], MoveType::ALL))
+        {
+            pos.take_move();
+            best_move = ml.moves[i];
+        }
+    }
+    std::cout << "bestmove ";
+    if (best_move)
+        print_move(best_move);
+    else
+        std::cout << "0000";
+    std::cout << std::endl;
+    return true;
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include "position.h"
+#include "uci.h"
+
+namespace JACEA
+{
+    /**
+     * Looks for a forced mate of the side to move in at most `moves` moves. The attacker only
+     * plays checks and the defender every evasion, deepened one move at a time so the shortest
+     * mate comes first. Much narrower than the normal search, but blind to quiet mating moves.
+     *
+     * Prints the mate and the bestmove as soon as one is proven and returns true. Also returns
+     * true after sending a bestmove when stopped, false when there is no such mate.
+     */
+    bool search_mate(Position &pos, UCISettings &uci, int moves);
+}
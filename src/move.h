@@ -11,60 +11,63 @@ namespace JACEA
         CAPTURES
     };
 
-    constexpr int flag_capture = (1ULL << 16);
-    constexpr int flag_enpassant = (1ULL << 17);
-    constexpr int flag_double_pawn_push = (1ULL << 18);
-    constexpr int flag_castle = (1ULL << 19);
+    // Bits 14-15 of a move
+    constexpr Move move_normal = 0;
+    constexpr Move move_promotion = 1 << 14;
+    constexpr Move move_enpassant = 2 << 14;
+    constexpr Move move_castle = 3 << 14;
 
     /**
      * Bits 0-5:    From square
      * Bits 6-11:   To square
-     * Bits 12-15:  Promoted Piece
-     * Bits 16+:    Flags
+     * Bits 12-13:  Promoted piece type (knight, bishop, rook, queen), only read for promotions
+     * Bits 14-15:  Special move kind
+     *
+     * The moving and captured pieces are read from the board and the color of a promoted
+     * piece follows from its rank, so a move fits in 16 bits. Move 0 (a8a8) means no move.
      */
-    Move inline create_move(Square from, Square to, Piece promotedPiece, int flags)
+    constexpr Move create_move(const Square from, const Square to, const Move kind = move_normal)
     {
-        return from | (to << 6) | (promotedPiece << 12) | flags;
+        return Move(from | (to << 6) | kind);
     }
 
-    inline Square get_from_square(const Move move)
+    // promoted_piece may be of either color
+    constexpr Move create_promotion(const Square from, const Square to, const Piece promoted_piece)
     {
-        return move & 0b111111;
+        return Move(from | (to << 6) | ((promoted_piece % 6 - N) << 12) | move_promotion);
     }
 
-    inline Square get_to_square(const Move move)
+    inline Square get_from_square(const Move move)
     {
-        return (move & 0b111111000000) >> 6;
+        return move & 0b111111;
     }
 
-    inline Piece get_promoted_piece(const Move move)
+    inline Square get_to_square(const Move move)
     {
-        return (move & 0b1111000000000000) >> 12;
+        return (move >> 6) & 0b111111;
     }
 
-    inline int is_capture(const Move move)
+    inline int is_promotion(const Move move)
     {
-        return move & flag_capture;
+        return (move & move_castle) == move_promotion;
     }
 
     inline int is_enpassant(const Move move)
     {
-        return move & flag_enpassant;
-    }
-
-    inline int is_doublepawnpush(const Move move)
-    {
-        return move & flag_double_pawn_push;
+        return (move & move_castle) == move_enpassant;
     }
 
     inline int is_castle(const Move move)
     {
-        return move & flag_castle;
+        return (move & move_castle) == move_castle;
     }
 
-    inline int is_quiet(const Move move)
+    // Colored promoted piece, only valid if is_promotion(move)
+    inline Piece get_promoted_piece(const Move move)
     {
-        return !(is_capture(move) || is_enpassant(move) || is_castle(move));
+        assert(is_promotion(move));
+        const Piece piece = N + ((move >> 12) & 0b11);
+        return get_to_square(move) <= h8 ? piece : piece + 6;
     }
 
 }
\ No newline at end of file
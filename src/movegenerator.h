@@ -23,7 +23,7 @@ namespace JACEA
                 return 200000;
             }
         }
-        if (is_capture(move))
+        if (pos.is_capture(move))
         {
             int piece = pos.get_piece_on_square(get_from_square(move));
             int captured_piece = pos.get_piece_on_square(get_to_square(move));
@@ -48,519 +48,257 @@ namespace JACEA
 
     static inline void add_move(Position &pos, MoveList &ml, const Move move, const Move best_move = 0)
     {
-        ml.moves[ml.size++] = {move, score_move(pos, move, best_move)};
+        ml.moves[ml.size] = move;
+        ml.scores[ml.size++] = score_move(pos, move, best_move);
     }
 
-    static inline void generate_moves(Position &pos, MoveList &ml, const Move best_move = 0)
+    // Moves the best scored move left in [index, size) to index and returns it,
+    // so a cutoff early in the list never pays for ordering the rest
+    static inline Move pick_move(MoveList &ml, const int index)
     {
-        if (pos.get_side() == WHITE)
+        int best = index;
+        for (int i = index + 1; i < ml.size; i++)
         {
-            for (int piece = P; piece <= K; piece++)
+            if (ml.scores[i] > ml.scores[best])
+                best = i;
+        }
+
+        std::swap(ml.moves[index], ml.moves[best]);
+        std::swap(ml.scores[index], ml.scores[best]);
+        return ml.moves[index];
+    }
+
+    enum class GenType
+    {
+        ALL,      // Every pseudo legal move
+        CAPTURES, // Captures, capture promotions and en passant
+        QUIETS,   // Everything ALL generates that CAPTURES does not
+        EVASIONS  // Pseudo legal moves that may resolve a check, side to move must be in check
+    };
+
+    static inline void add_promotions(Position &pos, MoveList &ml, const Square from_square, const Square to_square, const Move best_move)
+    {
+        add_move(pos, ml, create_promotion(from_square, to_square, Q), best_move);
+        add_move(pos, ml, create_promotion(from_square, to_square, N), best_move);
+        add_move(pos, ml, create_promotion(from_square, to_square, B), best_move);
+        add_move(pos, ml, create_promotion(from_square, to_square, R), best_move);
+    }
+
+    // target restricts destination squares, only used by evasions
+    template <Color Us, GenType Type>
+    static inline void generate_pawn_moves(Position &pos, MoveList &ml, const Bitboard target, const Move best_move)
+    {
+        constexpr Color Them = Us == WHITE ? BLACK : WHITE;
+        constexpr Direction Up = Us == WHITE ? Direction::UP : Direction::DOWN;
+        // Offset from a destination square back to the pawn that pushed there
+        constexpr int Back = Us == WHITE ? 8 : -8;
+        constexpr Bitboard StartRank = Us == WHITE ? SECOND_RANK : SEVENTH_RANK;
+        constexpr Bitboard PromotionRank = Us == WHITE ? EIGHTH_RANK : FIRST_RANK;
+
+        const Bitboard pawns = pos.get_piece_board(Us == WHITE ? P : p);
+        const Bitboard empty = ~pos.get_occupancy_board(BOTH);
+
+        if constexpr (Type != GenType::CAPTURES)
+        {
+            // Single pawn pushes
             {
-                u64 bb = pos.get_piece_board(piece);
-                switch (piece)
+                u64 single_pawn_push_moves = shift<Up>(pawns) & empty;
+                if constexpr (Type == GenType::EVASIONS)
+                    single_pawn_push_moves &= target;
+                while (single_pawn_push_moves)
                 {
-                case P:
-                    // Single pawn pushes
-                    {
-                        // White pawns getting shifted up one rank gives all quiet pawn pushes
-                        u64 single_pawn_push_moves = shift<Direction::UP>(bb) & ~pos.get_occupancy_board(BOTH);
-                        while (single_pawn_push_moves)
-                        {
-                            const int to_square = get_firstlsb_index(single_pawn_push_moves);
-
-                            // Promotion
-                            if (a8 <= to_square && to_square <= h8)
-                            {
-                                add_move(pos, ml, create_move(to_square + 8, to_square, Q, 0), best_move);
-                                add_move(pos, ml, create_move(to_square + 8, to_square, N, 0), best_move);
-                                add_move(pos, ml, create_move(to_square + 8, to_square, B, 0), best_move);
-                                add_move(pos, ml, create_move(to_square + 8, to_square, R, 0), best_move);
-                            }
-                            else
-                            {
-                                add_move(pos, ml, create_move(to_square + 8, to_square, 0, 0), best_move);
-                            }
-
-                            pop_bit(single_pawn_push_moves, to_square);
-                        }
-                    }
-                    // Double pawn push
-                    {
-                        // White pawns getting shifted up one rank gives all quiet pawn pushes
-                        u64 double_pawn_push_moves = shift<Direction::UP>(shift<Direction::UP>(bb & SECOND_RANK) & ~pos.get_occupancy_board(BOTH)) & ~pos.get_occupancy_board(BOTH);
-                        while (double_pawn_push_moves)
-                        {
-                            const int to_square = get_firstlsb_index(double_pawn_push_moves);
-
-                            add_move(pos, ml, create_move(to_square + 16, to_square, 0, flag_double_pawn_push), best_move);
-
-                            pop_bit(double_pawn_push_moves, to_square);
-                        }
-                    }
-                    // Pawn attacks
-                    {
-                        u64 pawns = bb;
-                        while (pawns)
-                        {
-                            const int from_square = get_firstlsb_index(pawns);
-                            u64 attacks = pawn_attacks[WHITE][from_square] & pos.get_occupancy_board(BLACK);
-
-                            while (attacks)
-                            {
-                                const int to_square = get_firstlsb_index(attacks);
-
-                                // Promotion
-                                if (a8 <= to_square && to_square <= h8)
-                                {
-                                    add_move(pos, ml, create_move(from_square, to_square, Q, flag_capture), best_move);
-                                    add_move(pos, ml, create_move(from_square, to_square, N, flag_capture), best_move);
-                                    add_move(pos, ml, create_move(from_square, to_square, B, flag_capture), best_move);
-                                    add_move(pos, ml, create_move(from_square, to_square, R, flag_capture), best_move);
-                                }
-                                else
-                                {
-                                    add_move(pos, ml, create_move(from_square, to_square, 0, flag_capture), best_move);
-                                }
-
-                                pop_bit(attacks, to_square);
-                            }
-
-                            if (pos.get_enpassant_square() != no_sq)
-                            {
-                                u64 enpassant_attack = pawn_attacks[WHITE][from_square] & (1ULL << pos.get_enpassant_square());
-                                if (enpassant_attack)
-                                {
-                                    add_move(pos, ml, create_move(from_square, get_firstlsb_index(enpassant_attack), 0, flag_enpassant), best_move);
-                                }
-                            }
-
-                            pop_bit(pawns, from_square);
-                        }
-                    }
-                    break;
-                case N:
-                    // Knight
-                    {
-                        u64 knights = bb;
-                        while (knights)
-                        {
-                            const int from_square = get_firstlsb_index(knights);
-                            u64 attacks = knight_attacks[from_square];
-                            attacks &= ~pos.get_occupancy_board(WHITE);
-                            while (attacks)
-                            {
-                                const int to_square = get_firstlsb_index(attacks);
-
-                                // Capture Move
-                                if (get_bit(pos.get_occupancy_board(BLACK), to_square))
-                                {
-                                    add_move(pos, ml, create_move(from_square, to_square, 0, flag_capture), best_move);
-                                }
-                                // Quiet Move
-                                else
-                                {
-                                    add_move(pos, ml, create_move(from_square, to_square, 0, 0), best_move);
-                                }
-
-                                pop_bit(attacks, to_square);
-                            }
-
-                            pop_bit(knights, from_square);
-                        }
-                    }
-                    break;
-                case B:
-                    // Bishop
-                    {
-                        u64 bishop = bb;
-                        while (bishop)
-                        {
-                            const int from_square = get_firstlsb_index(bishop);
-                            u64 attacks = get_bishop_attacks(from_square, pos.get_occupancy_board(BOTH)) & ~pos.get_occupancy_board(WHITE);
-                            while (attacks)
-                            {
-                                const int to_square = get_firstlsb_index(attacks);
-                                // Capture Move
-                                if (get_bit(pos.get_occupancy_board(BLACK), to_square))
-                                {
-                                    add_move(pos, ml, create_move(from_square, to_square, 0, flag_capture), best_move);
-                                }
-                                // Quiet Move
-                                else
-                                {
-                                    add_move(pos, ml, create_move(from_square, to_square, 0, 0), best_move);
-                                }
-
-                                pop_bit(attacks, to_square);
-                            }
-
-                            pop_bit(bishop, from_square);
-                        }
-                    }
-                    break;
-                case R:
-                    // Rook
-                    {
-                        u64 rooks = bb;
-                        while (rooks)
-                        {
-                            const int from_square = get_firstlsb_index(rooks);
-                            u64 attacks = get_rook_attacks(from_square, pos.get_occupancy_board(BOTH)) & ~pos.get_occupancy_board(WHITE);
-                            while (attacks)
-                            {
-                                const int to_square = get_firstlsb_index(attacks);
-
-                                // Capture Move
-                                if (get_bit(pos.get_occupancy_board(BLACK), to_square))
-                                {
-                                    add_move(pos, ml, create_move(from_square, to_square, 0, flag_capture), best_move);
-                                }
-                                // Quiet Move
-                                else
-                                {
-                                    add_move(pos, ml, create_move(from_square, to_square, 0, 0), best_move);
-                                }
-
-                                pop_bit(attacks, to_square);
-                            }
-
-                            pop_bit(rooks, from_square);
-                        }
-                    }
-                    break;
-                case Q:
-                    // Queen
-                    {
-                        u64 queens = bb;
-                        while (queens)
-                        {
-                            const int from_square = get_firstlsb_index(queens);
-                            u64 attacks = get_queen_attacks(from_square, pos.get_occupancy_board(BOTH)) & ~pos.get_occupancy_board(WHITE);
-                            while (attacks)
-                            {
-                                const int to_square = get_firstlsb_index(attacks);
-
-                                // Capture Move
-                                if (get_bit(pos.get_occupancy_board(BLACK), to_square))
-                                {
-                                    add_move(pos, ml, create_move(from_square, to_square, 0, flag_capture), best_move);
-                                }
-                                // Quiet Move
-                                else
-                                {
-                                    add_move(pos, ml, create_move(from_square, to_square, 0, 0), best_move);
-                                }
-
-                                pop_bit(attacks, to_square);
-                            }
-
-                            pop_bit(queens, from_square);
-                        }
-                    }
-                    break;
-                case K:
-                    // Castling
-                    {
-                        if ((pos.get_castling_perms() & wk) && !(pos.get_occupancy_board(BOTH) & WHITE_KING_CASTLE))
-                        {
-                            if (!pos.is_square_attacked(BLACK, e1) && !pos.is_square_attacked(BLACK, f1))
-                            {
-                                add_move(pos, ml, create_move(e1, g1, 0, flag_castle), best_move);
-                            }
-                        }
-                        if ((pos.get_castling_perms() & wq) && !(pos.get_occupancy_board(BOTH) & WHITE_QUEEN_CASTLE))
-                        {
-                            if (!pos.is_square_attacked(BLACK, e1) && !pos.is_square_attacked(BLACK, d1))
-                            {
-                                add_move(pos, ml, create_move(e1, c1, 0, flag_castle), best_move);
-                            }
-                        }
-                    }
-                    // Moves
-                    {
-                        u64 king = bb;
-                        const int from_square = get_firstlsb_index(king);
-                        u64 attacks = king_attacks[from_square];
-                        attacks &= ~pos.get_occupancy_board(WHITE);
-                        while (attacks)
-                        {
-                            const int to_square = get_firstlsb_index(attacks);
-
-                            // Capture Move
-                            if (get_bit(pos.get_occupancy_board(BLACK), to_square))
-                            {
-                                add_move(pos, ml, create_move(from_square, to_square, 0, flag_capture), best_move);
-                            }
-                            // Quiet Move
-                            else
-                            {
-                                add_move(pos, ml, create_move(from_square, to_square, 0, 0), best_move);
-                            }
-
-                            pop_bit(attacks, to_square);
-                        }
-                    }
-                    break;
-                default:
-                    assert(false);
+                    const int to_square = pop_lsb(single_pawn_push_moves);
+
+                    if (get_bit(PromotionRank, to_square))
+                        add_promotions(pos, ml, to_square + Back, to_square, best_move);
+                    else
+                        add_move(pos, ml, create_move(to_square + Back, to_square), best_move);
+                }
+            }
+            // Double pawn push
+            {
+                u64 double_pawn_push_moves = shift<Up>(shift<Up>(pawns & StartRank) & empty) & empty;
+                if constexpr (Type == GenType::EVASIONS)
+                    double_pawn_push_moves &= target;
+                while (double_pawn_push_moves)
+                {
+                    const int to_square = pop_lsb(double_pawn_push_moves);
+
+                    add_move(pos, ml, create_move(to_square + 2 * Back, to_square), best_move);
                 }
             }
         }
-        else
+
+        if constexpr (Type != GenType::QUIETS)
         {
-            for (int piece = p; piece <= k; piece++)
+            // Pawn attacks
+            Bitboard enemies = pos.get_occupancy_board(Them);
+            if constexpr (Type == GenType::EVASIONS)
+                enemies &= target;
+
+            // An en passant capture evades a check by the double pushed pawn or by blocking on the en passant square
+            Bitboard enpassant = 0ULL;
+            if (pos.get_enpassant_square() != no_sq)
             {
-                u64 bb = pos.get_piece_board(piece);
-                switch (piece)
+                set_bit(enpassant, pos.get_enpassant_square());
+                if constexpr (Type == GenType::EVASIONS)
                 {
-                case p:
-                    // Single pawn pushes
-                    {
-                        // White pawns getting shifted up one rank gives all quiet pawn pushes
-                        u64 single_pawn_push_moves = shift<Direction::DOWN>(bb) & ~pos.get_occupancy_board(BOTH);
-                        while (single_pawn_push_moves)
-                        {
-                            const int to_square = get_firstlsb_index(single_pawn_push_moves);
-
-                            // Promotion
-                            if (a1 <= to_square && to_square <= h1)
-                            {
-                                add_move(pos, ml, create_move(to_square - 8, to_square, q, 0), best_move);
-                                add_move(pos, ml, create_move(to_square - 8, to_square, n, 0), best_move);
-                                add_move(pos, ml, create_move(to_square - 8, to_square, b, 0), best_move);
-                                add_move(pos, ml, create_move(to_square - 8, to_square, r, 0), best_move);
-                            }
-                            else
-                            {
-                                add_move(pos, ml, create_move(to_square - 8, to_square, 0, 0), best_move);
-                            }
-
-                            pop_bit(single_pawn_push_moves, to_square);
-                        }
-                    }
-                    // Double pawn push
-                    {
-                        // White pawns getting shifted up one rank gives all quiet pawn pushes
-                        u64 double_pawn_push_moves = shift<Direction::DOWN>(shift<Direction::DOWN>(bb & SEVENTH_RANK) & ~pos.get_occupancy_board(BOTH)) & ~pos.get_occupancy_board(BOTH);
-                        while (double_pawn_push_moves)
-                        {
-                            const int to_square = get_firstlsb_index(double_pawn_push_moves);
-
-                            add_move(pos, ml, create_move(to_square - 16, to_square, 0, flag_double_pawn_push), best_move);
-
-                            pop_bit(double_pawn_push_moves, to_square);
-                        }
-                    }
-                    // Pawn attacks
-                    {
-                        u64 pawns = bb;
-                        while (pawns)
-                        {
-                            const int from_square = get_firstlsb_index(pawns);
-                            u64 attacks = pawn_attacks[BLACK][from_square] & pos.get_occupancy_board(WHITE);
-
-                            while (attacks)
-                            {
-                                const int to_square = get_firstlsb_index(attacks);
-
-                                // Promotion
-                                if (a1 <= to_square && to_square <= h1)
-                                {
-                                    add_move(pos, ml, create_move(from_square, to_square, q, flag_capture), best_move);
-                                    add_move(pos, ml, create_move(from_square, to_square, n, flag_capture), best_move);
-                                    add_move(pos, ml, create_move(from_square, to_square, b, flag_capture), best_move);
-                                    add_move(pos, ml, create_move(from_square, to_square, r, flag_capture), best_move);
-                                }
-                                else
-                                {
-                                    add_move(pos, ml, create_move(from_square, to_square, 0, flag_capture), best_move);
-                                }
-
-                                pop_bit(attacks, to_square);
-                            }
-
-                            if (pos.get_enpassant_square() != no_sq)
-                            {
-                                u64 enpassant_attack = pawn_attacks[BLACK][from_square] & (1ULL << pos.get_enpassant_square());
-                                if (enpassant_attack)
-                                {
-                                    add_move(pos, ml, create_move(from_square, get_firstlsb_index(enpassant_attack), 0, flag_enpassant), best_move);
-                                }
-                            }
-
-                            pop_bit(pawns, from_square);
-                        }
-                    }
-                    break;
-                case n:
-                    // Knight
-                    {
-                        u64 knights = bb;
-                        while (knights)
-                        {
-                            const int from_square = get_firstlsb_index(knights);
-                            u64 attacks = knight_attacks[from_square];
-                            attacks &= ~pos.get_occupancy_board(BLACK);
-                            while (attacks)
-                            {
-                                const int to_square = get_firstlsb_index(attacks);
-
-                                // Capture Move
-                                if (get_bit(pos.get_occupancy_board(WHITE), to_square))
-                                {
-                                    add_move(pos, ml, create_move(from_square, to_square, 0, flag_capture), best_move);
-                                }
-                                // Quiet Move
-                                else
-                                {
-                                    add_move(pos, ml, create_move(from_square, to_square, 0, 0), best_move);
-                                }
-
-                                pop_bit(attacks, to_square);
-                            }
-
-                            pop_bit(knights, from_square);
-                        }
-                    }
-                    break;
-                case b:
-                    // Bishop
-                    {
-                        u64 bishop = bb;
-                        while (bishop)
-                        {
-                            const int from_square = get_firstlsb_index(bishop);
-                            u64 attacks = get_bishop_attacks(from_square, pos.get_occupancy_board(BOTH)) & ~pos.get_occupancy_board(BLACK);
-                            while (attacks)
-                            {
-                                const int to_square = get_firstlsb_index(attacks);
-
-                                // Capture Move
-                                if (get_bit(pos.get_occupancy_board(WHITE), to_square))
-                                {
-                                    add_move(pos, ml, create_move(from_square, to_square, 0, flag_capture), best_move);
-                                }
-                                // Quiet Move
-                                else
-                                {
-                                    add_move(pos, ml, create_move(from_square, to_square, 0, 0), best_move);
-                                }
-
-                                pop_bit(attacks, to_square);
-                            }
-
-                            pop_bit(bishop, from_square);
-                        }
-                    }
-                    break;
-                case r:
-                    // Rook
-                    {
-                        u64 rook = bb;
-                        while (rook)
-                        {
-                            const int from_square = get_firstlsb_index(rook);
-                            u64 attacks = get_rook_attacks(from_square, pos.get_occupancy_board(BOTH)) & ~pos.get_occupancy_board(BLACK);
-                            while (attacks)
-                            {
-                                const int to_square = get_firstlsb_index(attacks);
-
-                                // Capture Move
-                                if (get_bit(pos.get_occupancy_board(WHITE), to_square))
-                                {
-                                    add_move(pos, ml, create_move(from_square, to_square, 0, flag_capture), best_move);
-                                }
-                                // Quiet Move
-                                else
-                                {
-                                    add_move(pos, ml, create_move(from_square, to_square, 0, 0), best_move);
-                                }
-
-                                pop_bit(attacks, to_square);
-                            }
-
-                            pop_bit(rook, from_square);
-                        }
-                    }
-                    break;
-                case q:
-                    // Queen
-                    {
-                        u64 queens = bb;
-                        while (queens)
-                        {
-                            const int from_square = get_firstlsb_index(queens);
-                            u64 attacks = get_queen_attacks(from_square, pos.get_occupancy_board(BOTH)) & ~pos.get_occupancy_board(BLACK);
-                            while (attacks)
-                            {
-                                const int to_square = get_firstlsb_index(attacks);
-
-                                // Capture Move
-                                if (get_bit(pos.get_occupancy_board(WHITE), to_square))
-                                {
-                                    add_move(pos, ml, create_move(from_square, to_square, 0, flag_capture), best_move);
-                                }
-                                // Quiet Move
-                                else
-                                {
-                                    add_move(pos, ml, create_move(from_square, to_square, 0, 0), best_move);
-                                }
-
-                                pop_bit(attacks, to_square);
-                            }
-
-                            pop_bit(queens, from_square);
-                        }
-                    }
-                    break;
-                case k:
-                    // Castling
-                    {
-                        if ((pos.get_castling_perms() & bk) && !(pos.get_occupancy_board(BOTH) & BLACK_KING_CASTLE))
-                        {
-                            if (!pos.is_square_attacked(WHITE, e8) && !pos.is_square_attacked(WHITE, f8))
-                            {
-                                add_move(pos, ml, create_move(e8, g8, 0, flag_castle), best_move);
-                            }
-                        }
-                        if ((pos.get_castling_perms() & bq) && !(pos.get_occupancy_board(BOTH) & BLACK_QUEEN_CASTLE))
-                        {
-                            if (!pos.is_square_attacked(WHITE, e8) && !pos.is_square_attacked(WHITE, d8))
-                            {
-                                add_move(pos, ml, create_move(e8, c8, 0, flag_castle), best_move);
-                            }
-                        }
-                    }
-                    // Moves
-                    {
-                        u64 king = bb;
-                        const int from_square = get_firstlsb_index(king);
-                        u64 attacks = king_attacks[from_square];
-                        attacks &= ~pos.get_occupancy_board(BLACK);
-                        while (attacks)
-                        {
-                            const int to_square = get_firstlsb_index(attacks);
-
-                            // Capture Move
-                            if (get_bit(pos.get_occupancy_board(WHITE), to_square))
-                            {
-                                add_move(pos, ml, create_move(from_square, to_square, 0, flag_capture), best_move);
-                            }
-                            // Quiet Move
-                            else
-                            {
-                                add_move(pos, ml, create_move(from_square, to_square, 0, 0), best_move);
-                            }
-
-                            pop_bit(attacks, to_square);
-                        }
-                    }
-                    break;
-                default:
-                    assert(false);
+                    if (!get_bit(target, pos.get_enpassant_square() + Back) && !(target & enpassant))
+                        enpassant = 0ULL;
                 }
             }
+
+            u64 pawn_bb = pawns;
+            while (pawn_bb)
+            {
+                const int from_square = pop_lsb(pawn_bb);
+                u64 attacks = pawn_attacks[Us][from_square] & enemies;
+
+                while (attacks)
+                {
+                    const int to_square = pop_lsb(attacks);
+
+                    if (get_bit(PromotionRank, to_square))
+                        add_promotions(pos, ml, from_square, to_square, best_move);
+                    else
+                        add_move(pos, ml, create_move(from_square, to_square), best_move);
+                }
+
+                const u64 enpassant_attack = pawn_attacks[Us][from_square] & enpassant;
+                if (enpassant_attack)
+                {
+                    add_move(pos, ml, create_move(from_square, lsb(enpassant_attack), move_enpassant), best_move);
+                }
+            }
+        }
+    }
+
+    // Knight, bishop, rook and queen moves landing on target, Pt is the white piece type
+    template <Color Us, Piece Pt>
+    static inline void generate_piece_moves(Position &pos, MoveList &ml, const Bitboard target, const Move best_move)
+    {
+        u64 pieces = pos.get_piece_board(Us == WHITE ? Pt : Pt + 6);
+        while (pieces)
+        {
+            const int from_square = pop_lsb(pieces);
+            u64 attacks;
+            if constexpr (Pt == N)
+                attacks = knight_attacks[from_square];
+            else if constexpr (Pt == B)
+                attacks = get_bishop_attacks(from_square, pos.get_occupancy_board(BOTH));
+            else if constexpr (Pt == R)
+                attacks = get_rook_attacks(from_square, pos.get_occupancy_board(BOTH));
+            else
+                attacks = get_queen_attacks(from_square, pos.get_occupancy_board(BOTH));
+            attacks &= target;
+
+            while (attacks)
+            {
+                const int to_square = pop_lsb(attacks);
+
+                add_move(pos, ml, create_move(from_square, to_square), best_move);
+            }
         }
     }
+
+    template <Color Us, GenType Type>
+    static inline void generate_king_moves(Position &pos, MoveList &ml, const Bitboard target, const Move best_move)
+    {
+        // Castling
+        if constexpr (Type == GenType::ALL || Type == GenType::QUIETS)
+        {
+            constexpr int king_side = Us == WHITE ? wk : bk;
+            constexpr int queen_side = Us == WHITE ? wq : bq;
+            constexpr Bitboard king_side_path = Us == WHITE ? WHITE_KING_CASTLE : BLACK_KING_CASTLE;
+            constexpr Bitboard queen_side_path = Us == WHITE ? WHITE_QUEEN_CASTLE : BLACK_QUEEN_CASTLE;
+            constexpr Square king_square = Us == WHITE ? e1 : e8;
+
+            if ((pos.get_castling_perms() & king_side) && !(pos.get_occupancy_board(BOTH) & king_side_path))
+            {
+                if (!pos.in_check() && !(pos.get_king_danger() & (1ULL << (king_square + 1))))
+                {
+                    add_move(pos, ml, create_move(king_square, king_square + 2, move_castle), best_move);
+                }
+            }
+            if ((pos.get_castling_perms() & queen_side) && !(pos.get_occupancy_board(BOTH) & queen_side_path))
+            {
+                if (!pos.in_check() && !(pos.get_king_danger() & (1ULL << (king_square - 1))))
+                {
+                    add_move(pos, ml, create_move(king_square, king_square - 2, move_castle), best_move);
+                }
+            }
+        }
+
+        // Moves
+        {
+            const int from_square = lsb(pos.get_piece_board(Us == WHITE ? K : k));
+            u64 attacks = king_attacks[from_square] & target;
+            while (attacks)
+            {
+                const int to_square = pop_lsb(attacks);
+
+                add_move(pos, ml, create_move(from_square, to_square), best_move);
+            }
+        }
+    }
+
+    // Pseudo legal moves of the given kind for Us, legality is checked by make_move
+    template <Color Us, GenType Type>
+    static inline void generate_moves(Position &pos, MoveList &ml, const Move best_move = 0)
+    {
+        constexpr Color Them = Us == WHITE ? BLACK : WHITE;
+
+        Bitboard target;
+        Bitboard king_target;
+        if constexpr (Type == GenType::ALL)
+        {
+            target = ~pos.get_occupancy_board(Us);
+            king_target = target;
+        }
+        else if constexpr (Type == GenType::CAPTURES)
+        {
+            target = pos.get_occupancy_board(Them);
+            king_target = target;
+        }
+        else if constexpr (Type == GenType::QUIETS)
+        {
+            target = ~pos.get_occupancy_board(BOTH);
+            king_target = target;
+        }
+        else
+        {
+            const Square king_square = pos.get_king_square(Us);
+            const Bitboard checkers = pos.get_checkers();
+            assert(checkers);
+
+            // Squares the king can not step to are known already, skip them here
+            king_target = ~pos.get_occupancy_board(Us) & ~pos.get_king_danger();
+
+            // Only the king can escape a double check
+            if (pop_count(checkers) > 1)
+            {
+                generate_king_moves<Us, Type>(pos, ml, king_target, best_move);
+                return;
+            }
+
+            // Capture the checker or block between it and the king
+            target = checkers | between_squares[king_square][lsb(checkers)];
+        }
+
+        generate_pawn_moves<Us, Type>(pos, ml, target, best_move);
+        generate_piece_moves<Us, N>(pos, ml, target, best_move);
+        generate_piece_moves<Us, B>(pos, ml, target, best_move);
+        generate_piece_moves<Us, R>(pos, ml, target, best_move);
+        generate_piece_moves<Us, Q>(pos, ml, target, best_move);
+        generate_king_moves<Us, Type>(pos, ml, king_target, best_move);
+    }
+
+    template <GenType Type = GenType::ALL>
+    static inline void generate_moves(Position &pos, MoveList &ml, const Move best_move = 0)
+    {
+        if (pos.get_side() == WHITE)
+            generate_moves<WHITE, Type>(pos, ml, best_move);
+        else
+            generate_moves<BLACK, Type>(pos, ml, best_move);
+    }
 }
\ No newline at end of file
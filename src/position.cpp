@@ -77,6 +77,17 @@ void JACEA::Position::check() const
 	assert(zobrist_key == generate_zobrist_key());
 	assert(pop_count(piece_boards[K]) == 1);
 	assert(pop_count(piece_boards[k]) == 1);
+
+	// NNUE lists must mirror the mailbox
+	assert(nnue_count == pop_count(occupancy[BOTH]));
+	assert(nnue_pieces[nnue_count] == 0);
+	for (Square sq = 0; sq < 64; sq++)
+	{
+		if (mailbox[sq] == None)
+			continue;
+		assert(nnue_pieces[nnue_slot[sq]] == to_nnue_piece[mailbox[sq]]);
+		assert(nnue_squares[nnue_slot[sq]] == to_nnue_square[sq]);
+	}
 #endif
 }
 
@@ -112,25 +123,18 @@ Position &JACEA::Position::operator=(const Position &rhs)
 	if (this == &rhs)
 		return *this;
 
-	zobrist_key = rhs.zobrist_key;
-	for (int i = 0; i < 12; i++)
-		piece_boards[i] = rhs.piece_boards[i];
-	for (int i = 0; i < 3; i++)
-		occupancy[i] = rhs.occupancy[i];
-	for (int i = 0; i < 64; i++)
-		mailbox[i] = rhs.mailbox[i];
-	side = rhs.side;
-	en_passant = rhs.en_passant;
-	castling = rhs.castling;
+	static_cast<BoardState &>(*this) = rhs;
 	ply = rhs.ply;
-	rule50 = rhs.rule50;
 
 	for (int i = 0; i < max_game_ply; i++)
 		history[i] = rhs.history[i];
 	history_size = rhs.history_size;
-
-	white_material = rhs.white_material;
-	black_material = rhs.black_material;
+#ifdef COPY_MAKE
+	for (int i = 0; i < history_size; i++)
+		states[i] = rhs.states[i];
+#endif
+	for (int i = 0; i <= history_size; i++)
+		check_info[i] = rhs.check_info[i];
 
 	for (int i = 0; i < max_game_depth; i++)
 	{
@@ -182,7 +186,18 @@ void JACEA::Position::reset()
 	white_material = 0;
 	black_material = 0;
 
+	for (int i = 0; i < 33; i++)
+	{
+		nnue_pieces[i] = 0;
+		nnue_squares[i] = 0;
+	}
+	for (int i = 0; i < 64; i++)
+		nnue_slot[i] = 0;
+	nnue_count = 2;
+
 	zobrist_key = generate_zobrist_key();
+
+	check_info[0] = CheckInfo{};
 }
 
 void JACEA::Position::init_from_fen(std::string fen)
@@ -257,9 +272,78 @@ void JACEA::Position::init_from_fen(std::string fen)
 	// For search
 	ply = 0;
 
+	update_check_info();
 	check();
 }
 
+void JACEA::Position::update_check_info()
+{
+	CheckInfo &ci = check_info[history_size];
+	const Color them = side ^ 1;
+	const int offset = them == WHITE ? 0 : 6;
+	const Square king_square = get_king_square(side);
+
+	ci.checkers = get_attackers(them, king_square);
+	ci.blockers_for_king = 0ULL;
+	ci.pinners = 0ULL;
+	ci.king_danger_valid = false;
+
+	// Enemy sliders that would see the king on an empty board, pinning if exactly one piece is in the way
+	Bitboard snipers = (get_bishop_attacks(king_square, 0ULL) & (piece_boards[B + offset] | piece_boards[Q + offset]))
+		| (get_rook_attacks(king_square, 0ULL) & (piece_boards[R + offset] | piece_boards[Q + offset]));
+	while (snipers)
+	{
+		const Square sniper = pop_lsb(snipers);
+		const Bitboard blockers = between_squares[king_square][sniper] & occupancy[BOTH];
+		if (blockers && !(blockers & (blockers - 1)))
+		{
+			ci.blockers_for_king |= blockers;
+			if (blockers & occupancy[side])
+				set_bit(ci.pinners, sniper);
+		}
+	}
+}
+
+// Whether a pseudo legal move leaves the own king safe, decided without making it
+bool JACEA::Position::is_legal(const Move move)
+{
+	const CheckInfo &ci = check_info[history_size];
+	const Square from_square = get_from_square(move);
+	const Square to_square = get_to_square(move);
+	const Square king_square = get_king_square(side);
+
+	if (from_square == king_square)
+	{
+		// Castling may not start in, pass through or end in check
+		if (is_castle(move))
+			return !ci.checkers && !(get_king_danger() & (between_squares[from_square][to_square] | (1ULL << to_square)));
+		return !(get_king_danger() & (1ULL << to_square));
+	}
+
+	// Two pieces at once can only be escaped by moving the king
+	if (ci.checkers & (ci.checkers - 1))
+		return false;
+
+	if (is_enpassant(move))
+	{
+		// Two pieces leave the rank at once, so just look for sliders on the resulting board
+		const Square captured_square = side == WHITE ? to_square + 8 : to_square - 8;
+		const Bitboard occupied = (occupancy[BOTH] ^ (1ULL << from_square) ^ (1ULL << captured_square)) | (1ULL << to_square);
+		const int offset = side == WHITE ? 6 : 0;
+
+		return !(get_bishop_attacks(king_square, occupied) & (piece_boards[B + offset] | piece_boards[Q + offset]))
+			&& !(get_rook_attacks(king_square, occupied) & (piece_boards[R + offset] | piece_boards[Q + offset]))
+			&& !(ci.checkers & ~(1ULL << captured_square) & (piece_boards[N + offset] | piece_boards[P + offset]));
+	}
+
+	// In check the move has to take the checker or step in between
+	if (ci.checkers && !((ci.checkers | between_squares[king_square][lsb(ci.checkers)]) & (1ULL << to_square)))
+		return false;
+
+	// A pinned piece may only move along the pin
+	return !(ci.blockers_for_king & occupancy[side] & (1ULL << from_square)) || (line_squares[king_square][from_square] & (1ULL << to_square));
+}
+
 bool JACEA::Position::make_move(Move move, const MoveType mt)
 {
 	if (mt == MoveType::CAPTURES)
@@ -269,12 +353,19 @@ bool JACEA::Position::make_move(Move move, const MoveType mt)
 		return make_move(move, MoveType::ALL);
 	}
 
+	if (!is_legal(move))
+		return false;
+
 	history[history_size].castling = castling;
 	history[history_size].en_passant = en_passant;
 	history[history_size].plies = ply;
 	history[history_size].rule50 = rule50;
 	history[history_size].move = move;
 	history[history_size].key = zobrist_key;
+	history[history_size].captured_piece = None;
+#ifdef COPY_MAKE
+	states[history_size] = static_cast<const BoardState &>(*this);
+#endif
 
 	// Remove enpassant and castle from key in case of change
 	if (en_passant != no_sq)
@@ -288,13 +379,13 @@ bool JACEA::Position::make_move(Move move, const MoveType mt)
 	const int from_square = get_from_square(move);
 	const int to_square = get_to_square(move);
 	const int piece = mailbox[from_square];
-	const int promoted_piece = get_promoted_piece(move);
-	const int is_capture_move = is_capture(move);
-	const int is_doublepawnpush_move = is_doublepawnpush(move);
-	const int is_castle_move = is_castle(move);
-	const int is_enpassant_move = is_enpassant(move);
+	const bool is_pawn_move = piece == P || piece == p;
+	const bool is_capture_move = mailbox[to_square] != None;
+	const bool is_doublepawnpush_move = is_pawn_move && (to_square - from_square == 16 || from_square - to_square == 16);
+	const bool is_castle_move = is_castle(move);
+	const bool is_enpassant_move = is_enpassant(move);
 
-	if (mailbox[from_square] == P || mailbox[from_square] == p)
+	if (is_pawn_move)
 	{
 		rule50 = 0;
 	}
@@ -346,15 +437,10 @@ bool JACEA::Position::make_move(Move move, const MoveType mt)
 	}
 
 	// Step 5: If its a promotion remove pawn from 8th/1st rank and add promoted piece
-	if (piece == P && a8 <= to_square && to_square <= h8)
-	{
-		take_piece(to_square);
-		add_piece(promoted_piece, to_square);
-	}
-	else if (piece == p && a1 <= to_square && to_square <= h1)
+	if (is_promotion(move))
 	{
 		take_piece(to_square);
-		add_piece(promoted_piece, to_square);
+		add_piece(get_promoted_piece(move), to_square);
 	}
 
 	// Step 6: Update enpassant square
@@ -380,24 +466,8 @@ bool JACEA::Position::make_move(Move move, const MoveType mt)
 
 	history_size++;
 
-	if (side == WHITE)
-	{
-		if (is_square_attacked(side, get_firstlsb_index(piece_boards[k])))
-		{
-			take_move();
-			check();
-			return false;
-		}
-	}
-	else
-	{
-		if (is_square_attacked(side, get_firstlsb_index(piece_boards[K])))
-		{
-			take_move();
-			check();
-			return false;
-		}
-	}
+	assert(!is_square_attacked(side, get_king_square(side ^ 1)));
+	update_check_info();
 	check();
 	return true;
 }
@@ -408,6 +478,11 @@ void JACEA::Position::take_move()
 	assert(history_size);
 	history_size--;
 
+#ifdef COPY_MAKE
+	ply = history[history_size].plies;
+	static_cast<BoardState &>(*this) = states[history_size];
+	check();
+#else
 	if (en_passant != no_sq)
 		zobrist_key ^= piece_position_key[12][en_passant];
 	zobrist_key ^= castle_perm_key[castling];
@@ -423,24 +498,17 @@ void JACEA::Position::take_move()
 
 	const int captured_piece = history[history_size].captured_piece;
 
-	const int move = history[history_size].move;
+	const Move move = history[history_size].move;
 	const int from_square = get_from_square(move);
 	const int to_square = get_to_square(move);
-	const int promoted_piece = get_promoted_piece(move);
-	const bool is_capture_move = is_capture(move);
 	const bool is_castle_move = is_castle(move);
 	const bool is_enpassant_move = is_enpassant(move);
 
 	// Step 1: If the move was a promotion, turn the promoted piece back into a pawn
-	if (promoted_piece != 0 && a8 <= to_square && to_square <= h8)
+	if (is_promotion(move))
 	{
 		take_piece(to_square);
-		add_piece(P, to_square);
-	}
-	else if (promoted_piece != 0 && a1 <= to_square && to_square <= h1)
-	{
-		take_piece(to_square);
-		add_piece(p, to_square);
+		add_piece(to_square <= h8 ? P : p, to_square);
 	}
 
 	// Step 2: Move piece(s) back to original square
@@ -480,7 +548,7 @@ void JACEA::Position::take_move()
 			add_piece(p, to_square + 8);
 		}
 	}
-	else if (is_capture_move)
+	else if (captured_piece != None)
 	{
 		add_piece(captured_piece, to_square);
 	}
@@ -489,6 +557,7 @@ void JACEA::Position::take_move()
 	side ^= 1;
 	zobrist_key ^= side_key;
 	check();
+#endif
 }
 
 void JACEA::Position::make_null_move()
@@ -507,6 +576,8 @@ void JACEA::Position::make_null_move()
 	history_size++;
 	side ^= 1;
 	zobrist_key ^= side_key;
+
+	update_check_info();
 }
 
 void JACEA::Position::take_null_move()
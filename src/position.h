@@ -19,20 +19,37 @@ namespace JACEA
 
     void init_zobrist_keys();
 
+    // Packed to 24 bytes, one entry is written per make_move
     struct PositionHistory
     {
         u64 key;
-        int castling;
-        int rule50;
-        int plies;
+        Move move;
+        uint16_t rule50;
+        uint16_t plies;
+        uint8_t castling;
         Square en_passant;
         Piece captured_piece;
-        Move move;
     };
 
-    class Position
+    /**
+     * Check and pin information for the side to move, computed once when a node is reached.
+     * Kept per ply rather than in BoardState so take_move gets the parent's copy back for free.
+     */
+    struct CheckInfo
+    {
+        Bitboard checkers;          // Enemy pieces giving check
+        Bitboard blockers_for_king; // Pieces of either color that are the only piece between an enemy slider and our king
+        Bitboard pinners;           // Enemy sliders pinning one of our pieces to the king
+        Bitboard king_danger;       // Squares the enemy attacks with our king taken off the board, see get_king_danger
+        bool king_danger_valid;
+    };
+
+    /**
+     * Everything make_move changes on the board, kept in one block so a copy-make
+     * build (COPY_MAKE) can save and restore it with a single copy per ply.
+     */
+    struct BoardState
     {
-    private:
         /**
          *  Position information
          */
@@ -42,20 +59,38 @@ namespace JACEA
         Piece mailbox[64];         // Each index represents the tile of enum eSquare
         Color side;                // Whos side is it to turn
         Square en_passant;         // The current en_passant square, set to no_sq if not avaiable
-        int castling;              // uses first 4 bits of data to hold castling perms of both sides
-        int ply;                   // ply is increased after each move made
+        uint8_t castling;          // uses first 4 bits of data to hold castling perms of both sides
         int rule50;                // Used for calling draws after no pawn move or capture in 50 moves
 
-        PositionHistory history[max_game_ply]; // Stores the previous move history to undo
-        int history_size = 0;
-
         /**
          *  Eval
          */
         int white_material; // white material score
         int black_material; // black material score
 
-        int killer_moves[2][max_game_depth];
+        /**
+         *  NNUE input, kept in the order the network expects so evaluation needs no board scan.
+         *  Slot 0 holds the white king, slot 1 the black king and the list ends with a 0 piece.
+         */
+        int nnue_pieces[33];
+        int nnue_squares[33];
+        uint8_t nnue_slot[64]; // Index into the nnue arrays for the piece on each square
+        int nnue_count;        // Used slots, including both kings
+    };
+
+    class Position : private BoardState
+    {
+    private:
+        int ply; // ply is increased after each move made
+
+        PositionHistory history[max_game_ply]; // Stores the previous move history to undo
+        int history_size = 0;
+#ifdef COPY_MAKE
+        BoardState states[max_game_ply]; // Board before each move in history, take_move copies it back
+#endif
+        CheckInfo check_info[max_game_ply + 1]; // Indexed by history_size, the current node is check_info[history_size]
+
+        Move killer_moves[2][max_game_depth];
         //[piece][square] score of move
         int history_moves[12][64];
 
@@ -80,6 +115,22 @@ namespace JACEA
             else
                 black_material += piece_to_value[piece];
 
+            // Kings are pinned to the first two slots, everything else is appended
+            int slot;
+            if (piece == K || piece == k)
+            {
+                slot = (piece == K) ? 0 : 1;
+            }
+            else
+            {
+                slot = nnue_count++;
+                nnue_pieces[nnue_count] = 0;
+                nnue_squares[nnue_count] = 0;
+            }
+            nnue_pieces[slot] = to_nnue_piece[piece];
+            nnue_squares[slot] = to_nnue_square[square];
+            nnue_slot[square] = slot;
+
             zobrist_key ^= piece_position_key[piece][square];
         }
 
@@ -98,6 +149,20 @@ namespace JACEA
             else
                 black_material -= piece_to_value[piece];
 
+            // Fill the hole with the last piece so the list stays contiguous.
+            // The king slots are simply overwritten by the following add_piece.
+            if (piece != K && piece != k)
+            {
+                const int slot = nnue_slot[square];
+                const int last = --nnue_count;
+                nnue_pieces[slot] = nnue_pieces[last];
+                nnue_squares[slot] = nnue_squares[last];
+                // to_nnue_square only flips the rank so it is its own inverse
+                nnue_slot[to_nnue_square[nnue_squares[last]]] = slot;
+                nnue_pieces[last] = 0;
+                nnue_squares[last] = 0;
+            }
+
             zobrist_key ^= piece_position_key[piece][square];
         }
 
@@ -107,11 +172,43 @@ namespace JACEA
             assert(mailbox[from_square] != None);
             assert(mailbox[to_square] == None);
             const Piece piece = mailbox[from_square];
-            take_piece(from_square);
-            add_piece(piece, to_square);
+            const Bitboard from_to = (1ULL << from_square) | (1ULL << to_square);
+
+            mailbox[from_square] = None;
+            mailbox[to_square] = piece;
+            piece_boards[piece] ^= from_to;
+            occupancy[color_from_piece[piece]] ^= from_to;
+            occupancy[BOTH] ^= from_to;
+
+            // The piece keeps its nnue slot, only the square changes
+            const int slot = nnue_slot[from_square];
+            nnue_squares[slot] = to_nnue_square[to_square];
+            nnue_slot[to_square] = slot;
+
+            zobrist_key ^= piece_position_key[piece][from_square] ^ piece_position_key[piece][to_square];
+        }
+
+        // Squares attacked by color with the given occupancy
+        inline Bitboard get_attacked_squares(const Color color, const Bitboard occupied) const
+        {
+            const int offset = color == WHITE ? 0 : 6;
+            const Bitboard pawns = piece_boards[P + offset];
+            Bitboard attacked = color == WHITE
+                                    ? shift<Direction::UP_LEFT>(pawns) | shift<Direction::UP_RIGHT>(pawns)
+                                    : shift<Direction::DOWN_LEFT>(pawns) | shift<Direction::DOWN_RIGHT>(pawns);
+
+            for (Bitboard bb = piece_boards[N + offset]; bb;)
+                attacked |= knight_attacks[pop_lsb(bb)];
+            for (Bitboard bb = piece_boards[B + offset] | piece_boards[Q + offset]; bb;)
+                attacked |= get_bishop_attacks(pop_lsb(bb), occupied);
+            for (Bitboard bb = piece_boards[R + offset] | piece_boards[Q + offset]; bb;)
+                attacked |= get_rook_attacks(pop_lsb(bb), occupied);
+
+            return attacked | king_attacks[lsb(piece_boards[K + offset])];
         }
 
         u64 generate_zobrist_key() const;
+        void update_check_info();
         void check() const;
 
     public:
@@ -120,6 +217,7 @@ namespace JACEA
         void reset();
         void init_from_fen(std::string fen);
 
+        bool is_legal(const Move move);
         bool make_move(Move move, const MoveType mt);
         void take_move();
         void make_null_move();
@@ -141,9 +239,32 @@ namespace JACEA
         inline Bitboard get_piece_on_square(const Square square) const { return mailbox[square]; }
         inline Bitboard get_piece_board(const Piece piece) const { return piece_boards[piece]; }
         inline Bitboard get_occupancy_board(const Color color) const { return occupancy[color]; }
-        inline Move get_first_killer_move() const { return killer_moves[0][ply]; }
-        inline Move get_second_killer_move() const { return killer_moves[1][ply]; }
-        inline Move get_history_move(const Piece piece, const Square square) const { return history_moves[piece][square]; }
+        inline const int *get_nnue_pieces() const { return nnue_pieces; }
+        inline const int *get_nnue_squares() const { return nnue_squares; }
+        // Quiescence can go deeper than the killer and pv tables, which then have nothing to offer
+        inline Move get_first_killer_move() const { return ply < max_game_depth ? killer_moves[0][ply] : 0; }
+        inline Move get_second_killer_move() const { return ply < max_game_depth ? killer_moves[1][ply] : 0; }
+        inline int get_history_move(const Piece piece, const Square square) const { return history_moves[piece][square]; }
+        // Only meaningful before the move is made
+        inline bool is_capture(const Move move) const { return mailbox[get_to_square(move)] != None; }
+        inline bool is_quiet(const Move move) const { return !is_capture(move) && !is_enpassant(move) && !is_castle(move); }
+        inline Square get_king_square(const Color color) const { return lsb(piece_boards[color == WHITE ? K : k]); }
+        inline Bitboard get_checkers() const { return check_info[history_size].checkers; }
+        inline bool in_check() const { return check_info[history_size].checkers != 0ULL; }
+        inline Bitboard get_blockers_for_king() const { return check_info[history_size].blockers_for_king; }
+        inline Bitboard get_pinned() const { return check_info[history_size].blockers_for_king & occupancy[side]; }
+        // Squares the side to move's king can not go to. Built on first use and reused for the rest of the node.
+        inline Bitboard get_king_danger()
+        {
+            CheckInfo &ci = check_info[history_size];
+            if (!ci.king_danger_valid)
+            {
+                const Bitboard king = piece_boards[side == WHITE ? K : k];
+                ci.king_danger = get_attacked_squares(side ^ 1, occupancy[BOTH] ^ king);
+                ci.king_danger_valid = true;
+            }
+            return ci.king_danger;
+        }
         inline bool is_last_move_null() const
         {
             return (history_size == 0) ? (false) : (history[history_size - 1].move == 0);
@@ -191,6 +312,22 @@ namespace JACEA
 
             return false;
         }
+        // All pieces of the attacker's color attacking square
+        inline Bitboard get_attackers(const Color attacker, const Square square) const
+        {
+            assert(attacker == WHITE || attacker == BLACK);
+            assert(0 <= square && square < 64);
+
+            const int offset = attacker == WHITE ? 0 : 6;
+            const Bitboard bishops_queens = piece_boards[B + offset] | piece_boards[Q + offset];
+            const Bitboard rooks_queens = piece_boards[R + offset] | piece_boards[Q + offset];
+
+            return (pawn_attacks[attacker ^ 1][square] & piece_boards[P + offset])
+                | (knight_attacks[square] & piece_boards[N + offset])
+                | (king_attacks[square] & piece_boards[K + offset])
+                | (get_bishop_attacks(square, occupancy[BOTH]) & bishops_queens)
+                | (get_rook_attacks(square, occupancy[BOTH]) & rooks_queens);
+        }
         inline bool three_fold_repetition()
         {
             int r = 0;
@@ -248,7 +385,7 @@ namespace JACEA
                 follow_pv = false;
                 for (int i = 0; i < ml.size; i++)
                 {
-                    if (pv_table[0][ply] == ml.moves[i].move)
+                    if (pv_table[0][ply] == ml.moves[i])
                     {
                         score_pv = true;
                         follow_pv = true;
@@ -259,7 +396,21 @@ namespace JACEA
         inline void follow_pv_true() { follow_pv = true; }
         inline void set_score_pv(const bool b) { score_pv = b; }
         inline Move get_pv_best() { return pv_table[0][0]; }
-        inline Move get_pv_ply() { return pv_table[0][ply]; }
+        // Copies the root pv into moves and returns its length
+        inline int get_pv_line(Move *moves) const
+        {
+            for (int i = 0; i < pv_length[0]; i++)
+                moves[i] = pv_table[0][i];
+            return pv_length[0];
+        }
+        // Sets the root pv that follow_pv walks in the next search
+        inline void load_pv(const Move *moves, const int length)
+        {
+            for (int i = 0; i < length; i++)
+                pv_table[0][i] = moves[i];
+            pv_length[0] = length;
+        }
+        inline Move get_pv_ply() { return ply < max_game_depth ? pv_table[0][ply] : 0; }
         inline bool get_should_score() { return score_pv; }
         inline int get_history_size() { return history_size; }
         inline void print_pv_line()
@@ -268,7 +419,7 @@ namespace JACEA
             {
                 Move move = pv_table[0][i];
                 std::cout << square_to_coordinate[get_from_square(move)] << square_to_coordinate[get_to_square(move)];
-                if (get_promoted_piece(move) != 0)
+                if (is_promotion(move))
                     std::cout << piece_to_string[get_promoted_piece(move)];
                 std::cout << " ";
             }
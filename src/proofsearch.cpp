@@ -0,0 +1,341 @@
+#include "proofsearch.h"
+#include "movegenerator.h"
+#include "search.h"
+#include "utility.h"
+#include "tablebase.h"
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+using namespace JACEA;
+
+// Proof and disproof numbers saturate here, a number this big means the goal can not be reached
+static constexpr uint32_t infinite_pn = 1u << 30;
+
+struct ProofEntry
+{
+    u64 key = 0;
+    uint32_t pn = 1;
+    uint32_t dn = 1;
+    u64 work = 0; // Nodes spent below the position, the more the more worth keeping
+};
+
+/**
+ * Proof and disproof numbers by position. Buckets of two, the first slot keeps the entry with
+ * the most work behind it and the second always takes the newest.
+ */
+class ProofTable
+{
+public:
+    explicit ProofTable(const size_t size_mb)
+        : entries(std::max<size_t>(size_mb * 1024 * 1024 / sizeof(ProofEntry) / 2, 1) * 2) {}
+
+    inline void clear() { std::fill(entries.begin(), entries.end(), ProofEntry()); }
+
+    // Positions not in the table start with pn = dn = 1
+    inline void lookup(const u64 key, uint32_t &pn, uint32_t &dn) const
+    {
+        const ProofEntry *bucket = &entries[key % (entries.size() / 2) * 2];
+        for (int i = 0; i < 2; i++)
+        {
+            if (bucket[i].key == key)
+            {
+                pn = bucket[i].pn;
+                dn = bucket[i].dn;
+                return;
+            }
+        }
+        pn = dn = 1;
+    }
+
+    inline void store(const u64 key, const uint32_t pn, const uint32_t dn, const u64 work)
+    {
+        ProofEntry *bucket = &entries[key % (entries.size() / 2) * 2];
+        ProofEntry *slot = &bucket[1];
+        if (bucket[0].key == key || work >= bucket[0].work)
+        {
+            if (bucket[0].key != key)
+                bucket[1] = bucket[0];
+            slot = &bucket[0];
+        }
+        *slot = {key, pn, dn, work};
+    }
+
+private:
+    std::vector<ProofEntry> entries;
+};
+
+struct Prover
+{
+    Prover(UCISettings &uci, const size_t table_mb, const u64 max_nodes) : uci(uci), table(table_mb), max_nodes(max_nodes) {}
+
+    UCISettings &uci;
+    ProofTable table;
+    Color attacker = WHITE; // Side whose win is being proven
+    u64 nodes = 0;          // Of the current pass, each pass gets max_nodes
+    u64 max_nodes = 0;
+    // A line hit the ply limit and was counted as failing, so a disproof is not a real one
+    bool truncated = false;
+};
+
+struct Child
+{
+    Move move;
+    u64 key;
+    uint32_t pn;
+    uint32_t dn;
+    bool path_draw; // Disproven by a draw that depends on the path here, see mid
+};
+
+static inline void set_proven(uint32_t &pn, uint32_t &dn)
+{
+    pn = 0;
+    dn = infinite_pn;
+}
+
+static inline void set_disproven(uint32_t &pn, uint32_t &dn)
+{
+    pn = infinite_pn;
+    dn = 0;
+}
+
+static inline uint32_t add_saturated(const uint32_t a, const uint32_t b)
+{
+    return uint32_t(std::min<u64>(u64(a) + b, infinite_pn));
+}
+
+// Bare kings or king and minor piece against a bare king, neither side can ever mate. With
+// more material a helpmate exists, e.g. K+N mates a king boxed in by its own pieces
+static inline bool dead_position(const Position &pos)
+{
+    const Bitboard heavy = pos.get_piece_board(P) | pos.get_piece_board(p) | pos.get_piece_board(R) |
+                           pos.get_piece_board(r) | pos.get_piece_board(Q) | pos.get_piece_board(q);
+    return !heavy && pop_count(pos.get_occupancy_board(BOTH)) <= 3;
+}
+
+// Value of a position decided by the draw rules or the tablebases, false when it has none.
+// path_draw is set for a draw by repetition or the fifty move rule, which only holds on this path
+static bool leaf_value(Prover &pr, Position &pos, uint32_t &pn, uint32_t &dn, bool &path_draw)
+{
+    path_draw = false;
+    if (dead_position(pos))
+    {
+        set_disproven(pn, dn);
+        return true;
+    }
+
+    if (pos.draw())
+    {
+        path_draw = true;
+        set_disproven(pn, dn);
+        return true;
+    }
+
+    if (!can_probe_wdl(pos, pop_count(pos.get_occupancy_board(BOTH)), int(TB_LARGEST)))
+        return false;
+
+    const unsigned res = probe_wdl(pos);
+    if (res == TB_RESULT_FAILED)
+        return false;
+
+    // Cursed wins and blessed losses are draws under the fifty move rule
+    const unsigned wdl = TB_GET_WDL(res);
+    const bool attacker_to_move = pos.get_side() == pr.attacker;
+    if ((wdl == TB_WIN && attacker_to_move) || (wdl == TB_LOSS && !attacker_to_move))
+        set_proven(pn, dn);
+    else
+        set_disproven(pn, dn);
+    return true;
+}
+
+static inline bool stopped(const Prover &pr)
+{
+    return pr.nodes >= pr.max_nodes || pr.uci.stop;
+}
+
+// Expands pos until its proof number reaches thpn or its disproof number thdn. The attacker
+// picks one move at OR nodes, every defender move has to work at AND nodes.
+//
+// Repetitions and the fifty move count depend on the way to a position, but the table is keyed by
+// position. A disproof that rests on such a draw is true for the current path only, so it is
+// returned through path_draw and kept in the parent's children but never stored in the table.
+static void mid(Prover &pr, Position &pos, const uint32_t thpn, const uint32_t thdn, uint32_t &pn, uint32_t &dn, bool &path_draw)
+{
+    pr.nodes++;
+    const u64 nodes_before = pr.nodes;
+    const bool or_node = pos.get_side() == pr.attacker;
+
+    // Too deep for the per ply tables, count it as a failure to reach the goal
+    if (pos.get_ply() >= max_game_depth - 1)
+    {
+        pr.truncated = true;
+        path_draw = true;
+        set_disproven(pn, dn);
+        return;
+    }
+
+    Child children[max_moves];
+    int size = 0;
+    MoveList ml;
+    generate_moves(pos, ml);
+    for (int i = 0; i < ml.size; i++)
+    {
+        const Move move = pick_move(ml, i);
+        if (!pos.make_move(move, MoveType::ALL))
+            continue;
+        Child &child = children[size++];
+        child.move = move;
+        child.key = pos.get_key();
+        if (!leaf_value(pr, pos, child.pn, child.dn, child.path_draw))
+            pr.table.lookup(child.key, child.pn, child.dn);
+        pos.take_move();
+    }
+
+    // Mated or stalemated, only mating the defender reaches the goal
+    path_draw = false;
+    if (size == 0)
+    {
+        if (pos.in_check() && !or_node)
+            set_proven(pn, dn);
+        else
+            set_disproven(pn, dn);
+        pr.table.store(pos.get_key(), pn, dn, 0);
+        return;
+    }
+
+    while (true)
+    {
+        // OR nodes take the smallest proof number and need all children to disprove, AND nodes the reverse
+        int best = 0;
+        uint32_t best_value = infinite_pn, second_value = infinite_pn, sum = 0;
+        for (int i = 0; i < size; i++)
+        {
+            const uint32_t value = or_node ? children[i].pn : children[i].dn;
+            sum = add_saturated(sum, or_node ? children[i].dn : children[i].pn);
+            if (value < best_value)
+            {
+                second_value = best_value;
+                best_value = value;
+                best = i;
+            }
+            else if (value < second_value)
+                second_value = value;
+        }
+        pn = or_node ? best_value : sum;
+        dn = or_node ? sum : best_value;
+
+        if (pn >= thpn || dn >= thdn || stopped(pr))
+            break;
+
+        // The child may work until it is no longer the best one or the parent passes its thresholds
+        Child &child = children[best];
+        uint32_t child_thpn, child_thdn;
+        if (or_node)
+        {
+            child_thpn = std::min(thpn, add_saturated(second_value, 1));
+            child_thdn = add_saturated(thdn - dn, child.dn);
+        }
+        else
+        {
+            child_thpn = add_saturated(thpn - pn, child.pn);
+            child_thdn = std::min(thdn, add_saturated(second_value, 1));
+        }
+
+        pos.make_move(child.move, MoveType::ALL);
+        mid(pr, pos, child_thpn, child_thdn, child.pn, child.dn, child.path_draw);
+        pos.take_move();
+    }
+
+    // An OR node is disproven by all of its children, an AND node by any one of them
+    if (dn == 0)
+    {
+        path_draw = !or_node;
+        for (int i = 0; i < size; i++)
+        {
+            if (children[i].dn == 0 && children[i].path_draw == or_node)
+            {
+                path_draw = or_node;
+                break;
+            }
+        }
+        if (path_draw)
+            return;
+    }
+
+    pr.table.store(pos.get_key(), pn, dn, pr.nodes - nodes_before);
+}
+
+// Runs df-pn from the root for a win of attacker. Returns the proof number, 0 is proven and
+// infinite_pn disproven. best_move is the proving move when it is proven
+static uint32_t prove_win(Prover &pr, Position &pos, const Color attacker, Move &best_move)
+{
+    pr.attacker = attacker;
+    pr.nodes = 0;
+    pr.truncated = false;
+    pr.table.clear();
+
+    uint32_t pn, dn;
+    bool path_draw;
+    mid(pr, pos, infinite_pn, infinite_pn, pn, dn, path_draw);
+
+    best_move = 0;
+    if (pn == 0 && pos.get_side() == attacker)
+    {
+        MoveList ml;
+        generate_moves(pos, ml);
+        for (int i = 0; i < ml.size && !best_move; i++)
+        {
+            if (!pos.make_move(ml.moves[i], MoveType::ALL))
+                continue;
+            uint32_t child_pn, child_dn;
+            bool child_path_draw;
+            if (!leaf_value(pr, pos, child_pn, child_dn, child_path_draw))
+                pr.table.lookup(pos.get_key(), child_pn, child_dn);
+            pos.take_move();
+            if (child_pn == 0)
+                best_move = ml.moves[i];
+        }
+    }
+    return pn;
+}
+
+void JACEA::prove(Position &pos, UCISettings &uci, const u64 max_nodes, const size_t table_mb)
+{
+    const auto start_time = get_time_ms();
+    Prover pr(uci, table_mb, max_nodes);
+    pos.init_search();
+
+    const Color us = pos.get_side();
+    const Color them = us == WHITE ? BLACK : WHITE;
+    Move best_move = 0;
+    const uint32_t win = prove_win(pr, pos, us, best_move);
+    const bool win_truncated = pr.truncated;
+    u64 nodes = pr.nodes;
+    Move refutation = 0;
+    const uint32_t loss = win == 0 ? infinite_pn : prove_win(pr, pos, them, refutation);
+    const bool loss_truncated = pr.truncated;
+    if (win != 0)
+        nodes += pr.nodes;
+
+    std::cout << "info string proof nodes " << nodes << " time " << get_time_ms() - start_time << std::endl;
+    if (win == 0)
+    {
+        std::cout << "info string result win";
+        if (best_move)
+        {
+            std::cout << " move ";
+            print_move(best_move);
+        }
+        std::cout << std::endl;
+    }
+    else if (loss == 0)
+        std::cout << "info string result loss" << std::endl;
+    else if (win == infinite_pn && !win_truncated && loss == infinite_pn && !loss_truncated)
+        std::cout << "info string result draw" << std::endl;
+    else if (loss == infinite_pn && !loss_truncated)
+        std::cout << "info string result unknown, at least a draw" << std::endl;
+    else if (win == infinite_pn && !win_truncated)
+        std::cout << "info string result unknown, at most a draw" << std::endl;
+    else
+        std::cout << "info string result unknown" << std::endl;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "position.h"
+#include "uci.h"
+
+namespace JACEA
+{
+    /**
+     * Solves pos with depth-first proof-number search (df-pn) instead of alpha-beta. It first
+     * tries to prove a win for the side to move, then a win for the opponent. Both disproven is
+     * a draw. Leaves are checkmate, stalemate, the draw rules and the Syzygy tables, there is no
+     * evaluation. That makes it very cheap in narrow forcing trees and hopeless in quiet ones.
+     * Draws by repetition or the fifty move rule depend on the path, disproofs resting on one
+     * are used on that path but not kept in the table. Only lines cut off at the ply limit make
+     * a result unknown.
+     *
+     * Each of the two passes may search max_nodes nodes, uci.stop ends both. Uses its own table of
+     * table_mb MB, separate from the search's hash table. Prints the result as info strings.
+     */
+    void prove(Position &pos, UCISettings &uci, u64 max_nodes, size_t table_mb);
+}
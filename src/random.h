@@ -4,13 +4,13 @@
 
 namespace JACEA
 {
-    static std::random_device rd;
-    static std::mt19937_64 mt19937_64(rd());
-    static std::uniform_int_distribution<u64> dist(0, std::llround(std::pow(2, 62)));
+    // Fixed seed, the hash keys and so the node counts of a search are the same in every process.
+    // The engine's raw output is used, distributions differ between standard libraries
+    static std::mt19937_64 mt19937_64(0x4a41434541ull);
 
     static inline u64 random_u64()
     {
-        return dist(mt19937_64);
+        return mt19937_64() >> 2;
     }
 
     static inline u64 generate_magic_number()
@@ -0,0 +1,141 @@
+#pragma once
+
+#include "movegenerator.h"
+#include "position.h"
+#include "types.h"
+#include <algorithm>
+#include <vector>
+
+namespace JACEA
+{
+    struct RootMove
+    {
+        Move move = 0;
+        int score = -value_infinite;          // Of the current iteration, -value_infinite unless it raised alpha
+        int previous_score = -value_infinite; // Of the last completed iteration
+        u64 nodes = 0;                        // Main thread nodes below the move, summed over the whole search
+        int pv_length = 0;
+        Move pv[max_game_depth] = {};
+    };
+
+    /**
+     * The legal root moves with what the search learned about them. Kept across iterations so
+     * the root is searched in the order of the last scores, with subtree size breaking ties.
+     * Each search thread works on its own copy.
+     */
+    class RootMoves
+    {
+    public:
+        int pv_index = 0; // Moves in front of it belong to earlier MultiPV lines and are skipped
+
+        // Legal moves of pos, only those in search_moves unless it is empty
+        inline void init(Position &pos, const std::vector<Move> &search_moves)
+        {
+            moves.clear();
+            pv_index = 0;
+            restricted = !search_moves.empty();
+
+            MoveList ml;
+            generate_moves(pos, ml);
+            for (int i = 0; i < ml.size; i++)
+            {
+                const Move move = ml.moves[i];
+                if (restricted && std::find(search_moves.begin(), search_moves.end(), move) == search_moves.end())
+                    continue;
+                if (!pos.make_move(move, MoveType::ALL))
+                    continue;
+                pos.take_move();
+
+                RootMove rm;
+                rm.move = move;
+                moves.push_back(rm);
+            }
+        }
+
+        inline int size() const { return int(moves.size()); }
+        inline RootMove &operator[](const int i) { return moves[i]; }
+        inline const RootMove &operator[](const int i) const { return moves[i]; }
+
+        inline RootMove *find(const Move move)
+        {
+            for (auto &rm : moves)
+                if (rm.move == move)
+                    return &rm;
+            return nullptr;
+        }
+
+        // Drops every move not in keep, the root is searched as if limited by searchmoves from then on
+        inline void retain(const std::vector<Move> &keep)
+        {
+            moves.erase(std::remove_if(moves.begin(), moves.end(), [&](const RootMove &rm) {
+                            return std::find(keep.begin(), keep.end(), rm.move) == keep.end();
+                        }),
+                        moves.end());
+            restricted = true;
+        }
+
+        // Whether a search of the root sees every legal move, only then is its score the root's value
+        inline bool is_complete() const { return pv_index == 0 && !restricted; }
+
+        // Keeps the scores of the iteration that just finished as the previous scores
+        inline void new_iteration()
+        {
+            for (auto &rm : moves)
+            {
+                rm.previous_score = rm.score;
+                rm.score = -value_infinite;
+            }
+        }
+
+        // Starts searching MultiPV line pv_index, its moves are ordered by what is known of them
+        inline void start_line(const int index)
+        {
+            pv_index = index;
+            for (int i = pv_index; i < size(); i++)
+                moves[i].score = -value_infinite;
+            sort();
+        }
+
+        // Orders the moves from pv_index on. Moves that never raised alpha all score -value_infinite,
+        // the bigger subtree was harder to refute and goes first.
+        inline void sort()
+        {
+            std::stable_sort(moves.begin() + pv_index, moves.end(), [](const RootMove &a, const RootMove &b) {
+                if (a.score != b.score)
+                    return a.score > b.score;
+                if (a.previous_score != b.previous_score)
+                    return a.previous_score > b.previous_score;
+                return a.nodes > b.nodes;
+            });
+        }
+
+        // Sorts the finished MultiPV lines best first
+        inline void sort_lines(const int lines)
+        {
+            std::stable_sort(moves.begin(), moves.begin() + lines, [](const RootMove &a, const RootMove &b) { return a.score > b.score; });
+        }
+
+        // Fills ml with the moves still to search, scored so pick_move keeps their order
+        inline void fill(MoveList &ml) const
+        {
+            ml.size = 0;
+            for (int i = pv_index; i < size(); i++)
+            {
+                ml.moves[ml.size] = moves[i].move;
+                ml.scores[ml.size++] = size() - i;
+            }
+        }
+
+        inline u64 total_nodes() const
+        {
+            u64 total = 0;
+            for (const auto &rm : moves)
+                total += rm.nodes;
+            return total;
+        }
+
+    private:
+        std::vector<RootMove> moves;
+        bool restricted = false; // Limited by go searchmoves
+    };
+}
@@ -6,78 +6,170 @@
 #include <algorithm>
 #include <thread>
 #include "random.h"
-#include "tbprobe.h"
+#include "rootmoves.h"
+#include "tablebase.h"
 #include <future>
 
 using namespace JACEA;
 
-static inline bool compareDescendingMoves(const ScoredMove &a, const ScoredMove &b)
+// Safety margin on top of the captured piece for delta pruning in quiescence
+static constexpr int delta_margin = 200;
+
+// Reading the clock costs more than searching a node, so every thread only looks once per poll_interval nodes.
+// Under a node limit poll_countdown is also the number of nodes the thread has claimed and not searched yet
+static constexpr int poll_interval = 1024;
+static thread_local int poll_countdown = 0;
+
+// Nodes this thread searched that are not in uci.total_nodes yet, added in batches to keep the shared counter cold
+static thread_local u64 pending_nodes = 0;
+
+static inline void flush_nodes(UCISettings &uci)
 {
-	return a.score > b.score;
+	uci.total_nodes.fetch_add(pending_nodes, std::memory_order_relaxed);
+	pending_nodes = 0;
 }
 
+// Called before searching a node, sets uci.stop when the node may not be searched
 static inline void update_stop(UCISettings &uci)
 {
-	uci.stop |= uci.completed_iteration && get_time_ms() > uci.time_to_stop;
+	if (poll_countdown-- > 0)
+		return;
+	flush_nodes(uci);
+	poll_countdown = poll_interval - 1;
+
+	// Nodes are claimed before they are searched, so all threads together never search more than
+	// the limit. The batches shrink towards the end so no thread sits on a large unused claim
+	if (uci.node_limit)
+	{
+		const u64 claimed = uci.claimed_nodes.load(std::memory_order_relaxed);
+		const u64 batch = std::clamp<u64>((uci.node_limit > claimed ? uci.node_limit - claimed : 0) / (2 * uci.threads), 1, poll_interval);
+		const u64 first = uci.claimed_nodes.fetch_add(batch, std::memory_order_relaxed);
+		if (first >= uci.node_limit)
+		{
+			poll_countdown = 0;
+			uci.stop = true;
+			return;
+		}
+		poll_countdown = int(std::min(batch, uci.node_limit - first)) - 1;
+	}
+
+	if (!uci.completed_iteration)
+		return;
+	// While pondering the clock is not ours yet, ponderhit sets the real deadline
+	if (!uci.ponder && get_time_ms() > uci.time_to_stop)
+		uci.stop = true;
 }
 
-static inline int quiesence(bool mainThread, JACEA::Position &pos, int alpha, int beta, UCISettings &uci)
+static inline int quiesence(bool mainThread, JACEA::Position &pos, int alpha, int beta, TranspositionTable &tt, UCISettings &uci)
 {
-	if (mainThread)
+	update_stop(uci);
+	if (uci.stop)
 	{
-		uci.nodes++;
-		uci.largest_depth = std::max(uci.largest_depth, pos.get_ply());
+		return 0;
 	}
 
-	if (uci.nodes & 15000) // ~ each ms
-	{
-		update_stop(uci);
-	}
-	if (uci.stop)
+	pending_nodes++;
+	if (mainThread)
 	{
-		return 0;
+		uci.nodes++;
+		uci.largest_depth = std::max(uci.largest_depth, pos.get_ply());
 	}
 	if (pos.get_ply() >= max_game_ply)
 		return evaluation(pos);
 
-	int eval = evaluation(pos);
+	// Quiescence entries are stored with depth 0, so any entry of the position can cut off here
+	Move tt_move = 0;
+	int score;
+	if ((score = tt.read_hash_entry(pos, alpha, beta, 0, tt_move)) != TranspositionTable::no_hash && pos.get_fifty() < 90)
+		return score;
 
-	if (eval >= beta)
-		return beta;
+	int flag_hash = TranspositionTable::flag_hash_alpha;
+	Move best_move = 0;
 
-	if (eval > alpha)
+	// In check there is no standing pat, every evasion is searched instead
+	const bool in_check = pos.in_check();
+
+	int eval = 0;
+	if (!in_check)
 	{
-		alpha = eval;
+		eval = evaluation(pos);
+
+		if (eval >= beta)
+		{
+			tt.record_hash(pos, 0, beta, TranspositionTable::flag_hash_beta, 0);
+			return beta;
+		}
+
+		if (eval > alpha)
+		{
+			flag_hash = TranspositionTable::flag_hash_exact;
+			alpha = eval;
+		}
+
+		// Delta pruning - not even winning a queen gets back to alpha. A pawn about to
+		// promote can gain more than that, so leave those positions alone
+		const Bitboard promoting = pos.get_side() == WHITE ? pos.get_piece_board(P) & SEVENTH_RANK : pos.get_piece_board(p) & SECOND_RANK;
+		if (!promoting && eval + piece_to_value[Q] + delta_margin <= alpha)
+			return alpha;
 	}
 
+	int legal_moves = 0;
+
 	MoveList ml;
-	generate_moves(pos, ml);
-	std::sort(ml.moves, ml.moves + ml.size, compareDescendingMoves);
+	if (in_check)
+		generate_moves<GenType::EVASIONS>(pos, ml, tt_move);
+	else
+		generate_moves<GenType::CAPTURES>(pos, ml, tt_move);
 	for (int i = 0; i < ml.size; i++)
 	{
-		if (!pos.make_move(ml.moves[i].move, MoveType::CAPTURES))
+		const Move move = pick_move(ml, i);
+
+		// Futility - skip captures that can not lift the stand pat score to alpha
+		if (!in_check && !is_promotion(move))
+		{
+			const int gain = is_enpassant(move) ? piece_to_value[P] : piece_to_value[pos.get_piece_on_square(get_to_square(move))];
+			if (eval + gain + delta_margin <= alpha)
+				continue;
+		}
+
+		if (!pos.make_move(move, MoveType::ALL))
 			continue;
 
-		const int score = -quiesence(mainThread, pos, -beta, -alpha, uci);
+		legal_moves++;
+
+		score = -quiesence(mainThread, pos, -beta, -alpha, tt, uci);
 
 		pos.take_move();
 
+		if (uci.stop)
+			return 0;
+
 		// PV move found
 		if (score > alpha)
 		{
+			flag_hash = TranspositionTable::flag_hash_exact;
+			best_move = move;
 			alpha = score;
 
 			// Fail-hard (failed high)
 			if (score >= beta)
+			{
+				tt.record_hash(pos, 0, beta, TranspositionTable::flag_hash_beta, move);
 				return beta;
+			}
 		}
 	}
 
+	if (in_check && legal_moves == 0)
+		return mated_in(pos.get_ply());
+
+	tt.record_hash(pos, 0, alpha, flag_hash, best_move);
+
 	// failed low
 	return alpha;
 }
 
-static inline int negamax(bool mainThread, JACEA::Position &pos, int alpha, int beta, int depth, TranspositionTable &tt, UCISettings &uci)
+static inline int negamax(bool mainThread, JACEA::Position &pos, int alpha, int beta, int depth, TranspositionTable &tt, UCISettings &uci, RootMoves &root_moves)
 {
 	bool pv_node = (beta - alpha) > 1;
 	int eval = evaluation(pos);
@@ -85,30 +177,35 @@ static inline int negamax(bool mainThread, JACEA::Position &pos, int alpha, int
 	int flag_hash = TranspositionTable::flag_hash_alpha;
 	bool skip_quiet_moves = false;
 	int reduction;
+	Move tt_move = 0;
+	Move best_move = 0;
 
 	if (uci.stop_threads)
 		return 0;
-	pos.update_current_pv_length();
 
-	if (mainThread)
-	{
-		uci.nodes++;
-		uci.largest_depth = std::max(uci.largest_depth, pos.get_ply());
-	}
+	// The killer and pv tables only cover max_game_depth plies
+	if (pos.get_ply() >= max_game_depth - 1)
+		return eval;
 
-	if ((uci.nodes & 2048) == 0) // ~ each ms
-	{
-		update_stop(uci);
-	}
+	update_stop(uci);
 
 	if (uci.stop)
 	{
 		return 0;
 	}
 
+	pos.update_current_pv_length();
+
+	pending_nodes++;
+	if (mainThread)
+	{
+		uci.nodes++;
+		uci.largest_depth = std::max(uci.largest_depth, pos.get_ply());
+	}
+
 	if (depth <= 0)
 	{
-		return quiesence(mainThread, pos, alpha, beta, uci);
+		return quiesence(mainThread, pos, alpha, beta, tt, uci);
 	}
 
 	if (pos.get_ply())
@@ -117,12 +214,7 @@ static inline int negamax(bool mainThread, JACEA::Position &pos, int alpha, int
 		// detect drawing lines in a winning position
 		if (pos.get_ply() != 0 && pos.draw())
 		{
-			return 1 - (uci.nodes & 2);
-		}
-
-		if (pos.get_ply() >= max_game_ply)
-		{
-			return evaluation(pos);
+			return 1 - (pending_nodes & 2);
 		}
 
 		// Mate distance pruning
@@ -132,32 +224,22 @@ static inline int negamax(bool mainThread, JACEA::Position &pos, int alpha, int
 			return alpha;
 
 		// Transposition table lookup
-		if (((score = tt.read_hash_entry(pos, alpha, beta, depth)) != TranspositionTable::no_hash) && !pv_node && pos.get_fifty() < 90)
+		if (((score = tt.read_hash_entry(pos, alpha, beta, depth, tt_move)) != TranspositionTable::no_hash) && !pv_node && pos.get_fifty() < 90)
 		{
 			return score;
 		}
 
-		// Tablebase lookup
-		if (pop_count(pos.get_occupancy_board(BOTH)) <= 5)
+		// Tablebase lookup - at the piece limit only with enough depth left to be worth the disk access
+		const int pieces = pop_count(pos.get_occupancy_board(BOTH));
+		if (can_probe_wdl(pos, pieces, uci.syzygy_probe_limit) && (pieces < uci.syzygy_probe_limit || depth >= uci.syzygy_probe_depth))
 		{
-			if (mainThread)
-				uci.table_base_hits++;
-
-			unsigned res = tb_probe_wdl(bswap64(pos.get_occupancy_board(WHITE)),
-										bswap64(pos.get_occupancy_board(BLACK)),
-										bswap64(pos.get_piece_board(k) | pos.get_piece_board(K)),
-										bswap64(pos.get_piece_board(q) | pos.get_piece_board(Q)),
-										bswap64(pos.get_piece_board(r) | pos.get_piece_board(R)),
-										bswap64(pos.get_piece_board(b) | pos.get_piece_board(B)),
-										bswap64(pos.get_piece_board(n) | pos.get_piece_board(N)),
-										bswap64(pos.get_piece_board(p) | pos.get_piece_board(P)),
-										pos.get_fifty(),
-										pos.get_castling_perms(),
-										pos.get_enpassant_square() == no_sq ? 0 : pos.get_enpassant_square(),
-										pos.get_side() ^ 1);
+			unsigned res = probe_wdl(pos);
 
 			if (res != TB_RESULT_FAILED)
 			{
+				if (mainThread)
+					uci.table_base_hits++;
+
 				unsigned wdl = TB_GET_WDL(res);
 				switch (wdl)
 				{
@@ -182,24 +264,24 @@ static inline int negamax(bool mainThread, JACEA::Position &pos, int alpha, int
 		}
 	}
 
-	bool in_check = pos.is_square_attacked(pos.get_side() ^ 1, (pos.get_side() == WHITE) ? get_firstlsb_index(pos.get_piece_board(K)) : get_firstlsb_index(pos.get_piece_board(k)));
+	const bool in_check = pos.in_check();
 
 	if (in_check)
 		depth++;
 
 	// Razoring
 	int razor_value = eval + 125;
-	if (pos.get_ply() && razor_value < beta)
+	if (pos.get_ply() && !in_check && razor_value < beta)
 	{
 		if (depth == 1)
 		{
-			int new_val = quiesence(mainThread, pos, alpha, beta, uci);
+			int new_val = quiesence(mainThread, pos, alpha, beta, tt, uci);
 			return std::max(new_val, razor_value);
 		}
 		razor_value += 175;
 		if (razor_value < beta && depth <= 3)
 		{
-			int new_val = quiesence(mainThread, pos, alpha, beta, uci);
+			int new_val = quiesence(mainThread, pos, alpha, beta, tt, uci);
 			if (new_val < beta)
 			{
 				return std::max(new_val, razor_value);
@@ -229,7 +311,7 @@ static inline int negamax(bool mainThread, JACEA::Position &pos, int alpha, int
 
 		pos.make_null_move();
 
-		int null_score = -negamax(mainThread, pos, -beta, -beta + 1, depth - depth_reduction, tt, uci);
+		int null_score = -negamax(mainThread, pos, -beta, -beta + 1, depth - depth_reduction, tt, uci, root_moves);
 
 		pos.take_null_move();
 
@@ -241,19 +323,27 @@ static inline int negamax(bool mainThread, JACEA::Position &pos, int alpha, int
 
 	int legal_moves = 0;
 
+	// The root searches its own move list in the order of the last iteration. Elsewhere in check
+	// only the king moves, captures of the checker and blocks on its ray are generated
 	MoveList ml;
-	generate_moves(pos, ml);
+	if (pos.get_ply() == 0)
+		root_moves.fill(ml);
+	else if (in_check)
+		generate_moves<GenType::EVASIONS>(pos, ml, tt_move);
+	else
+		generate_moves(pos, ml, tt_move);
 
 	pos.update_follow_pv(ml);
 
-	std::stable_sort(ml.moves, ml.moves + ml.size, compareDescendingMoves);
-
 	for (int i = 0; i < ml.size; i++)
 	{
-		if (!pos.make_move(ml.moves[i].move, MoveType::ALL))
-			continue;
+		const Move move = pick_move(ml, i);
+		const bool is_quiet_move = pos.is_quiet(move);
+		const bool is_capture_move = pos.is_capture(move);
+		const u64 nodes_before = uci.nodes;
 
-		bool is_quiet_move = is_quiet(ml.moves[i].move);
+		if (!pos.make_move(move, MoveType::ALL))
+			continue;
 
 		if (is_quiet_move && skip_quiet_moves)
 		{
@@ -261,7 +351,7 @@ static inline int negamax(bool mainThread, JACEA::Position &pos, int alpha, int
 			continue;
 		}
 
-		if (eval > -value_mate_lower && depth <= 8 && legal_moves >= 4.0 + 4 * depth * depth / 4.5)
+		if (!in_check && eval > -value_mate_lower && depth <= 8 && legal_moves >= 4.0 + 4 * depth * depth / 4.5)
 		{
 			skip_quiet_moves = true;
 		}
@@ -283,44 +373,59 @@ static inline int negamax(bool mainThread, JACEA::Position &pos, int alpha, int
 		// If we hit Late Move Reduction search with reduced depth with modified bounds
 		if (reduction != -1)
 		{
-			score = -negamax(mainThread, pos, -alpha - 1, -alpha, depth - reduction, tt, uci);
+			score = -negamax(mainThread, pos, -alpha - 1, -alpha, depth - reduction, tt, uci, root_moves);
 		}
 
 		// If our late move reduction returned a value outside of our alpha bound rerun with normal depth
 		if ((reduction != -1 && score > alpha) || (reduction == 1 && !(pv_node && legal_moves == 1)))
 		{
-			score = -negamax(mainThread, pos, -alpha - 1, -alpha, depth - 1, tt, uci);
+			score = -negamax(mainThread, pos, -alpha - 1, -alpha, depth - 1, tt, uci, root_moves);
 		}
 
 		// If we are in a pv line and we played a move that beat alpha even on reduced depth,
 		// re-search the move with normal bounds and normal depth
 		if (pv_node && (legal_moves == 1 || score > alpha))
 		{
-			score = -negamax(mainThread, pos, -beta, -alpha, depth - 1, tt, uci);
+			score = -negamax(mainThread, pos, -beta, -alpha, depth - 1, tt, uci, root_moves);
 		}
 
 		pos.take_move();
 
-		if (uci.stop_threads)
+		// A cut off subtree returns 0, that must not reach the root moves, the pv or the hash table
+		if (uci.stop_threads || uci.stop)
 			return 0;
 
+		RootMove *root_move = pos.get_ply() == 0 ? root_moves.find(move) : nullptr;
+		if (root_move)
+		{
+			if (mainThread)
+				root_move->nodes += uci.nodes - nodes_before;
+			// Only a move that raised alpha has a usable score, the rest sort by subtree size
+			root_move->score = (score > alpha || legal_moves == 1) ? score : -value_infinite;
+		}
+
 		// PV move found
 		if (score > alpha)
 		{
 			flag_hash = TranspositionTable::flag_hash_exact;
-			if (!is_capture(ml.moves[i].move))
-				pos.update_history(ml.moves[i].move, depth);
+			if (!is_capture_move)
+				pos.update_history(move, depth);
 
 			alpha = score;
+			best_move = move;
 
-			pos.update_pv(ml.moves[i].move);
+			pos.update_pv(move);
+			if (root_move)
+				root_move->pv_length = pos.get_pv_line(root_move->pv);
 
 			// Fail-hard (failed high)
 			if (score >= beta)
 			{
-				tt.record_hash(pos, depth, beta, TranspositionTable::flag_hash_beta);
-				if (!is_capture(ml.moves[i].move))
-					pos.update_killer(ml.moves[i].move);
+				// A root searched without some of its moves does not have the root's real score
+				if (pos.get_ply() || root_moves.is_complete())
+					tt.record_hash(pos, depth, beta, TranspositionTable::flag_hash_beta, move);
+				if (!is_capture_move)
+					pos.update_killer(move);
 				return beta;
 			}
 		}
@@ -335,23 +440,31 @@ static inline int negamax(bool mainThread, JACEA::Position &pos, int alpha, int
 		return 0;
 	}
 
-	tt.record_hash(pos, depth, alpha, flag_hash);
+	if (pos.get_ply() || root_moves.is_complete())
+		tt.record_hash(pos, depth, alpha, flag_hash, best_move);
 
 	// failed low
 	return alpha;
 }
 
-static inline int aspiration(bool mainThread, JACEA::Position &pos, TranspositionTable &tt, UCISettings &uci, int depth, int score)
+static inline int aspiration(bool mainThread, JACEA::Position &pos, TranspositionTable &tt, UCISettings &uci, RootMoves &root_moves, int depth, int score)
 {
 	if (depth == 1)
-		return negamax(true, pos, -value_infinite, value_infinite, depth, tt, uci);
+	{
+		score = negamax(true, pos, -value_infinite, value_infinite, depth, tt, uci, root_moves);
+		root_moves.sort();
+		return score;
+	}
 
 	int delta = 25;
 	int alpha = std::max(score - delta, -value_infinite);
 	int beta = std::min(score + delta, value_infinite);
 	for (; !uci.stop; delta += delta / 2)
 	{
-		score = negamax(mainThread, pos, alpha, beta, depth, tt, uci);
+		score = negamax(mainThread, pos, alpha, beta, depth, tt, uci, root_moves);
+
+		// Whatever raised alpha in this attempt is searched first in the next one
+		root_moves.sort();
 
 		if (score <= alpha)
 		{
@@ -371,77 +484,248 @@ static inline int aspiration(bool mainThread, JACEA::Position &pos, Transpositio
 	return 0;
 }
 
+// One search of the root by one thread. Its nodes are counted in uci.total_nodes by the time it returns
+static int search_root(bool mainThread, JACEA::Position &pos, TranspositionTable &tt, UCISettings &uci, RootMoves &root_moves, int depth, int score)
+{
+	// Start every search at the same point of the polling cycle, single threaded searches then stop at the same node
+	poll_countdown = 0;
+	score = aspiration(mainThread, pos, tt, uci, root_moves, depth, score);
+	flush_nodes(uci);
+
+	// Hand back what is left of the claim for the next search
+	if (uci.node_limit && poll_countdown > 0)
+		uci.claimed_nodes.fetch_sub(poll_countdown, std::memory_order_relaxed);
+	poll_countdown = 0;
+	return score;
+}
+
+void JACEA::print_move(const Move move)
+{
+	std::cout << square_to_coordinate[get_from_square(move)] << square_to_coordinate[get_to_square(move)];
+	if (is_promotion(move))
+		std::cout << piece_to_string[get_promoted_piece(move)];
+}
+
+// Expected reply to best_move when the pv got cut short, taken from the hash move after it
+static Move ponder_move(JACEA::Position &pos, TranspositionTable &tt, const Move best_move)
+{
+	if (!best_move || !pos.make_move(best_move, MoveType::ALL))
+		return 0;
+
+	Move reply = 0;
+	tt.read_hash_entry(pos, -value_infinite, value_infinite, 0, reply);
+
+	// The hash move can come from a colliding key, only keep it if it is legal here
+	MoveList ml;
+	generate_moves(pos, ml);
+	bool legal = false;
+	for (int i = 0; i < ml.size && reply; i++)
+	{
+		if (ml.moves[i] == reply && pos.make_move(reply, MoveType::ALL))
+		{
+			pos.take_move();
+			legal = true;
+			break;
+		}
+	}
+
+	pos.take_move();
+	return legal ? reply : 0;
+}
+
+static void print_line(const RootMove &line, const int multipv, const int depth, const UCISettings &uci, const long long elapsed)
+{
+	const int score = line.score;
+	if (score > -value_mate && score < -value_mate_lower)
+	{
+		printf("info multipv %d score mate %d depth %d seldepth %d nodes %llu time %llu tbhits %llu pv ", multipv, -(score + value_mate + 1) / 2, depth, uci.largest_depth, uci.total_nodes.load(), elapsed, uci.table_base_hits);
+	}
+	else if (score > value_mate_lower && score < value_mate)
+	{
+		printf("info multipv %d score mate %d depth %d seldepth %d nodes %llu time %llu tbhits %llu pv ", multipv, (value_mate - score + 1) / 2, depth, uci.largest_depth, uci.total_nodes.load(), elapsed, uci.table_base_hits);
+	}
+	else
+	{
+		printf("info multipv %d score cp %d depth %d seldepth %d nodes %llu time %llu tbhits %llu pv ", multipv, score, depth, uci.largest_depth, uci.total_nodes.load(), elapsed, uci.table_base_hits);
+	}
+	for (int i = 0; i < line.pv_length; i++)
+	{
+		print_move(line.pv[i]);
+		std::cout << " ";
+	}
+	std::cout << std::endl;
+}
+
 void start_workers(JACEA::Position &pos, TranspositionTable &tt, UCISettings &uci, int depth, int workers)
 {
-	int score = 0;
 	auto start_time = get_time_ms();
-	int real_best = 0;
+	Move real_best = 0;
+	Move real_ponder = 0;
 	pos.init_search();
 	uci.completed_iteration = false;
 	uci.table_base_hits = 0;
 	uci.nodes = 0;
+	uci.total_nodes = 0;
+	uci.claimed_nodes = 0;
+	tt.new_search();
+
+	RootMoves root_moves;
+	root_moves.init(pos, uci.search_moves);
+
+	// In the tablebases only the moves that keep the result are searched. With a single line
+	// the tables already know the answer and the search is skipped
+	int tb_score = 0;
+	const Move tb_move = pop_count(pos.get_occupancy_board(BOTH)) <= uci.syzygy_probe_limit ? rank_root_moves(pos, root_moves, tb_score) : 0;
+	const bool resolved = tb_move && uci.multi_pv == 1;
+	if (tb_move)
+		uci.table_base_hits++;
+	if (resolved)
+	{
+		RootMove &line = *root_moves.find(tb_move);
+		line.score = tb_score;
+		line.pv[0] = tb_move;
+		line.pv_length = 1;
+		print_line(line, 1, 1, uci, get_time_ms() - start_time);
+		real_best = tb_move;
+	}
+
+	// Can not show more lines than there are moves to search
+	const int multi_pv = std::min(root_moves.size(), uci.multi_pv);
 
 	// Intialize workers
 	auto threadPositions = std::vector<JACEA::Position>(workers);
+	auto threadRootMoves = std::vector<RootMoves>(workers);
 	auto threads = std::vector<std::thread>(workers);
 	for (int i = 0; i < workers; i++)
 	{
 		threadPositions[i] = pos;
 	}
-	for (int current_depth = 1; current_depth <= depth;)
+	bool stopped_first_line = false;
+	for (int current_depth = 1; current_depth <= depth && !resolved;)
 	{
-		pos.follow_pv_true();
-		for (int i = 0; i < workers; i++)
-		{
-			threadPositions[i].follow_pv_true();
-		}
-		uci.stop_threads = false;
 		uci.largest_depth = 0;
-		for (int i = 0; i < workers; i++)
-		{
-			threads[i] = std::thread(aspiration, false, std::ref(threadPositions[i]), std::ref(tt), std::ref(uci), current_depth + i / 2 + 1, score);
-		}
-		score = aspiration(true, pos, tt, uci, current_depth, score);
-		uci.stop_threads = true;
-		for (int i = 0; i < workers; i++)
-		{
-			if (threads[i].joinable())
-				threads[i].join();
-		}
+		root_moves.new_iteration();
 
-		if (!uci.stop)
+		// Each line searches the root moves behind the best moves of the lines before it
+		for (int pv_index = 0; pv_index < multi_pv; pv_index++)
 		{
-			real_best = pos.get_pv_best();
+			root_moves.start_line(pv_index);
+
+			// Start from this line's pv of the last iteration, not from whatever line was searched last
+			const RootMove &line = root_moves[pv_index];
+			pos.load_pv(line.pv, line.pv_length);
+			pos.follow_pv_true();
+			for (int i = 0; i < workers; i++)
+			{
+				threadRootMoves[i] = root_moves;
+				threadPositions[i].load_pv(line.pv, line.pv_length);
+				threadPositions[i].follow_pv_true();
+			}
+			const int previous_score = line.previous_score == -value_infinite ? 0 : line.previous_score;
+
+			uci.stop_threads = false;
+			for (int i = 0; i < workers; i++)
+			{
+				threads[i] = std::thread(search_root, false, std::ref(threadPositions[i]), std::ref(tt), std::ref(uci), std::ref(threadRootMoves[i]), current_depth + i / 2 + 1, previous_score);
+			}
+			const int score = search_root(true, pos, tt, uci, root_moves, current_depth, previous_score);
+			uci.stop_threads = true;
+			for (int i = 0; i < workers; i++)
+			{
+				if (threads[i].joinable())
+					threads[i].join();
+			}
+
+			if (uci.stop)
+			{
+				stopped_first_line = pv_index == 0;
+				break;
+			}
+
+			root_moves[pv_index].score = score;
 		}
-		else
-		{
+		root_moves.pv_index = 0;
+
+		if (uci.stop)
 			break;
-		}
-		if (score > -value_mate && score < -value_mate_lower)
+
+		// A later line can come out better than an earlier one, present them best first
+		root_moves.sort_lines(multi_pv);
+		if (root_moves.size())
 		{
-			printf("info score mate %d depth %d seldepth %d nodes %llu time %llu tbhits %llu pv ", -(score + value_mate + 1) / 2, current_depth, uci.largest_depth, uci.nodes, get_time_ms() - start_time, uci.table_base_hits);
+			real_best = root_moves[0].move;
+			real_ponder = root_moves[0].pv_length > 1 ? root_moves[0].pv[1] : 0;
 		}
-		else if (score > value_mate_lower && score < value_mate)
+
+		for (int pv_index = 0; pv_index < multi_pv; pv_index++)
+			print_line(root_moves[pv_index], pv_index + 1, current_depth, uci, get_time_ms() - start_time);
+
+		uci.completed_iteration = true;
+		current_depth++;
+
+		// go mate is answered by the first mate that is short enough
+		if (uci.mate_limit && root_moves.size() && root_moves[0].score >= value_mate - (2 * uci.mate_limit - 1))
+			break;
+
+		const u64 total_nodes = root_moves.total_nodes();
+		const double best_move_share = (total_nodes && root_moves.size()) ? double(root_moves[0].nodes) / double(total_nodes) : 1.0;
+		if (uci.time_manager.stop_after_iteration(get_time_ms(), real_best, root_moves.size() ? root_moves[0].score : 0, best_move_share) && !uci.ponder)
+			break;
+	}
+
+	// The root moves the stopped iteration finished still count. One that scored above the last
+	// best move's score in this iteration is the better move, even without the rest of the iteration
+	if (stopped_first_line)
+	{
+		const RootMove *best = nullptr;
+		for (int i = 0; i < root_moves.size(); i++)
 		{
-			printf("info score mate %d depth %d seldepth %d nodes %llu time %llu tbhits %llu pv ", (value_mate - score + 1) / 2, current_depth, uci.largest_depth, uci.nodes, get_time_ms() - start_time, uci.table_base_hits);
+			if (root_moves[i].score != -value_infinite && (!best || root_moves[i].score > best->score))
+				best = &root_moves[i];
 		}
-		else
+		const RootMove *previous = real_best ? root_moves.find(real_best) : nullptr;
+		if (best && (!previous || best->score > previous->previous_score))
 		{
-			printf("info score cp %d depth %d seldepth %d nodes %llu time %llu tbhits %llu pv ", score, current_depth, uci.largest_depth, uci.nodes, get_time_ms() - start_time, uci.table_base_hits);
+			real_best = best->move;
+			real_ponder = best->pv_length > 1 ? best->pv[1] : 0;
 		}
-		pos.print_pv_line();
-		std::cout << std::endl;
-
-		uci.completed_iteration = true;
-		current_depth++;
 	}
-	std::cout << "bestmove " << square_to_coordinate[get_from_square(real_best)] << square_to_coordinate[get_to_square(real_best)];
-	if (get_promoted_piece(real_best) != 0)
-		std::cout << piece_to_string[get_promoted_piece(real_best)];
+	// Stopped before any move was searched to the end, the move ordering's first choice is all there is
+	if (!real_best && root_moves.size())
+		real_best = root_moves[0].move;
+
+	// bestmove may not be sent while pondering, even when the search is already done
+	while (uci.ponder && !uci.stop)
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+	// How far past the hard deadline the search got before it noticed, should stay within a few ms
+	const auto now = get_time_ms();
+	if (uci.stop && !uci.ponder && uci.time_manager.is_limited() && now >= uci.time_to_stop)
+		printf("info string stopped %lld ms after the deadline\n", static_cast<long long>(now - uci.time_to_stop));
+
+	// Includes the unfinished iteration, so a node limited search shows where it really stopped
+	printf("info nodes %llu time %lld\n", uci.total_nodes.load(), static_cast<long long>(now - start_time));
+
+	if (!real_ponder)
+		real_ponder = ponder_move(pos, tt, real_best);
+
+	// Mated or stalemated at the root, there is no move to send
+	std::cout << "bestmove ";
+	if (real_best)
+		print_move(real_best);
+	else
+		std::cout << "0000";
+	if (real_ponder)
+	{
+		std::cout << " ponder ";
+		print_move(real_ponder);
+	}
 	std::cout << std::endl;
 }
 
 void JACEA::search(JACEA::Position &pos, TranspositionTable &tt, UCISettings &uci, int depth)
 {
-	start_workers(pos, tt, uci, depth, 4);
+	// Helper threads share the hash table and race each other, only a single thread gives the same
+	// result every time. The table is cleared on a new position, see the position command
+	start_workers(pos, tt, uci, depth, uci.deterministic ? 0 : uci.threads - 1);
 }
\ No newline at end of file
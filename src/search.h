@@ -16,4 +16,7 @@ namespace JACEA
     }
 
     void search(Position &pos, TranspositionTable &tt, UCISettings &uci, int depth);
+
+    // Prints the move in UCI notation, e.g. e7e8q
+    void print_move(Move move);
 }
\ No newline at end of file
@@ -0,0 +1,112 @@
+#include "tablebase.h"
+#include "utility.h"
+#include <vector>
+
+using namespace JACEA;
+
+// Fathom numbers squares from a1, JACEA from a8. Boards are byte swapped and squares flipped on the way
+static inline unsigned to_fathom_square(const Square square)
+{
+    return square ^ 56;
+}
+
+unsigned JACEA::probe_wdl(const Position &pos)
+{
+    const Square ep = pos.get_enpassant_square();
+    return tb_probe_wdl(bswap64(pos.get_occupancy_board(WHITE)),
+                        bswap64(pos.get_occupancy_board(BLACK)),
+                        bswap64(pos.get_piece_board(k) | pos.get_piece_board(K)),
+                        bswap64(pos.get_piece_board(q) | pos.get_piece_board(Q)),
+                        bswap64(pos.get_piece_board(r) | pos.get_piece_board(R)),
+                        bswap64(pos.get_piece_board(b) | pos.get_piece_board(B)),
+                        bswap64(pos.get_piece_board(n) | pos.get_piece_board(N)),
+                        bswap64(pos.get_piece_board(p) | pos.get_piece_board(P)),
+                        pos.get_fifty(),
+                        pos.get_castling_perms(),
+                        ep == no_sq ? 0 : to_fathom_square(ep),
+                        pos.get_side() == WHITE);
+}
+
+unsigned JACEA::probe_root(const Position &pos, unsigned *results)
+{
+    const Square ep = pos.get_enpassant_square();
+    return tb_probe_root(bswap64(pos.get_occupancy_board(WHITE)),
+                         bswap64(pos.get_occupancy_board(BLACK)),
+                         bswap64(pos.get_piece_board(k) | pos.get_piece_board(K)),
+                         bswap64(pos.get_piece_board(q) | pos.get_piece_board(Q)),
+                         bswap64(pos.get_piece_board(r) | pos.get_piece_board(R)),
+                         bswap64(pos.get_piece_board(b) | pos.get_piece_board(B)),
+                         bswap64(pos.get_piece_board(n) | pos.get_piece_board(N)),
+                         bswap64(pos.get_piece_board(p) | pos.get_piece_board(P)),
+                         pos.get_fifty(),
+                         pos.get_castling_perms(),
+                         ep == no_sq ? 0 : to_fathom_square(ep),
+                         pos.get_side() == WHITE,
+                         results);
+}
+
+// The root move a Fathom result stands for, 0 when it is not among the root moves
+static Move to_root_move(RootMoves &root_moves, const unsigned result)
+{
+    const int from = to_fathom_square(TB_GET_FROM(result));
+    const int to = to_fathom_square(TB_GET_TO(result));
+    const unsigned promotes = TB_GET_PROMOTES(result);
+
+    for (int i = 0; i < root_moves.size(); i++)
+    {
+        const Move move = root_moves[i].move;
+        if (get_from_square(move) != from || get_to_square(move) != to)
+            continue;
+
+        unsigned move_promotes = TB_PROMOTES_NONE;
+        if (is_promotion(move))
+        {
+            switch (get_promoted_piece(move))
+            {
+            case Q: case q: move_promotes = TB_PROMOTES_QUEEN; break;
+            case R: case r: move_promotes = TB_PROMOTES_ROOK; break;
+            case B: case b: move_promotes = TB_PROMOTES_BISHOP; break;
+            default: move_promotes = TB_PROMOTES_KNIGHT; break;
+            }
+        }
+        if (move_promotes == promotes)
+            return move;
+    }
+    return 0;
+}
+
+Move JACEA::rank_root_moves(const Position &pos, RootMoves &root_moves, int &score)
+{
+    if (pop_count(pos.get_occupancy_board(BOTH)) > int(TB_LARGEST) || pos.get_castling_perms())
+        return 0;
+
+    unsigned results[TB_MAX_MOVES];
+    const unsigned res = probe_root(pos, results);
+    if (res == TB_RESULT_FAILED || res == TB_RESULT_CHECKMATE || res == TB_RESULT_STALEMATE)
+        return 0;
+
+    // Excluded by go searchmoves, the search has to make do without the tables
+    const Move best_move = to_root_move(root_moves, res);
+    if (!best_move)
+        return 0;
+
+    const unsigned wdl = TB_GET_WDL(res);
+    std::vector<Move> keep;
+    for (int i = 0; i < TB_MAX_MOVES && results[i] != TB_RESULT_FAILED; i++)
+    {
+        const Move move = TB_GET_WDL(results[i]) == wdl ? to_root_move(root_moves, results[i]) : 0;
+        if (move)
+            keep.push_back(move);
+    }
+    root_moves.retain(keep);
+
+    // Scored below the mate scores, a shorter distance to zeroing is the better win
+    const int dtz = TB_GET_DTZ(res);
+    if (wdl == TB_WIN)
+        score = value_mate_lower - 1 - dtz;
+    else if (wdl == TB_LOSS)
+        score = -value_mate_lower + 1 + dtz;
+    else
+        score = 0;
+    return best_move;
+}
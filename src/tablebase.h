@@ -0,0 +1,26 @@
+#pragma once
+
+#include "position.h"
+#include "rootmoves.h"
+#include "tbprobe.h"
+
+namespace JACEA
+{
+    // WDL is only exact right after a capture or pawn move and without castling rights, Fathom
+    // fails any other probe. Checking first saves converting the boards for nothing
+    inline bool can_probe_wdl(const Position &pos, const int pieces, const int probe_limit)
+    {
+        return pieces <= probe_limit && pieces <= int(TB_LARGEST) && pos.get_fifty() == 0 && !pos.get_castling_perms();
+    }
+
+    // Fathom probes of pos, TB_RESULT_FAILED when it is not in the tables
+    unsigned probe_wdl(const Position &pos);
+    unsigned probe_root(const Position &pos, unsigned *results);
+
+    /**
+     * Ranks the root moves with the DTZ tables. Only the moves that keep the root's WDL result
+     * stay in root_moves, and the one the tables prefer is returned with its score: the fastest
+     * win, or the slowest loss. Returns 0 and leaves root_moves alone when pos is not in the tables.
+     */
+    Move rank_root_moves(const Position &pos, RootMoves &root_moves, int &score);
+}
@@ -0,0 +1,67 @@
+#include "timemanager.h"
+#include <algorithm>
+
+void JACEA::TimeManager::init(long long start, long long time_left, long long increment, int moves_to_go, long long move_time)
+{
+    start_time = start;
+    iteration_start = start;
+    previous_best = 0;
+    previous_score = 0;
+    stability = 0;
+    fixed_time = move_time > 0;
+
+    if (move_time > 0)
+    {
+        limited = true;
+        // An overhead that eats most of a short movetime still leaves half of it to search
+        optimum = maximum = std::max(move_time - move_overhead, std::max(move_time / 2, 1LL));
+        return;
+    }
+    if (time_left < 0)
+    {
+        limited = false;
+        optimum = maximum = 0;
+        return;
+    }
+
+    limited = true;
+
+    // Without movestogo plan as if 40 moves are left until the next time control
+    const int moves = moves_to_go > 0 ? std::min(moves_to_go, 50) : 40;
+    const long long usable = std::max(time_left - move_overhead, 1LL);
+
+    optimum = usable / moves + increment * 3 / 4;
+    // Never bet more than half the clock on one move, unless it is the last before the time control
+    maximum = std::min(optimum * 5, moves == 1 ? usable * 9 / 10 : usable / 2);
+    optimum = std::min(optimum, maximum);
+}
+
+bool JACEA::TimeManager::stop_after_iteration(long long now, Move best_move, int score, double best_move_share)
+{
+    const long long last_iteration = now - iteration_start;
+    iteration_start = now;
+
+    if (!limited || fixed_time)
+        return false;
+
+    // A best move that keeps changing needs more time, a settled one less
+    stability = best_move == previous_best ? std::min(stability + 1, 6) : 0;
+    double scale = 1.6 - 0.12 * stability;
+
+    // Spend up to 50% more while the score is falling
+    if (previous_best && score < previous_score - 20)
+        scale *= 1.0 + std::min(previous_score - score, 200) / 400.0;
+
+    // The more of the tree the best move takes, the less likely another move overtakes it
+    scale *= 1.6 - best_move_share;
+
+    previous_best = best_move;
+    previous_score = score;
+
+    const long long elapsed = now - start_time;
+    if (elapsed >= std::min(static_cast<long long>(optimum * scale), maximum))
+        return true;
+
+    // The next iteration usually takes about twice as long as this one, do not start it when it can not finish
+    return elapsed + 2 * last_iteration > maximum;
+}
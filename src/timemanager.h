@@ -0,0 +1,46 @@
+#pragma once
+
+#include "bitboard.h"
+#include "move.h"
+#include <atomic>
+
+namespace JACEA
+{
+    /**
+     * Decides how long one search may take. The optimum time is the target for a normal move and
+     * is scaled after every iteration by how settled the search looks, the maximum time is never
+     * exceeded. All times are in ms.
+     */
+    class TimeManager
+    {
+    public:
+        int move_overhead = 100; // Kept back on every move for the GUI and communication lag
+
+        // time_left < 0 and move_time <= 0 means the search has no time limit
+        void init(long long start, long long time_left, long long increment, int moves_to_go, long long move_time);
+
+        // Moves the start of the search to now, for ponderhit. Everything else stays as set up by init
+        inline void restart(const long long now) { start_time = now; }
+
+        // Called after each completed iteration, true when no further iteration should be started.
+        // best_move_share is the part of the main thread's root nodes spent below the best move.
+        bool stop_after_iteration(long long now, Move best_move, int score, double best_move_share);
+
+        inline bool is_limited() const { return limited; }
+        inline long long get_optimum() const { return optimum; }
+        inline long long get_maximum() const { return maximum; }
+        inline long long hard_deadline() const { return start_time + maximum; }
+
+    private:
+        bool limited = false;
+        bool fixed_time = false; // go movetime, only the hard deadline ends the search
+        std::atomic<long long> start_time = 0; // Moved by ponderhit on the UCI thread
+        long long optimum = 0;
+        long long maximum = 0;
+        long long iteration_start = 0;
+
+        Move previous_best = 0;
+        int previous_score = 0;
+        int stability = 0; // Iterations in a row the best move stayed the same
+    };
+}
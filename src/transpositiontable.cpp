@@ -17,10 +17,12 @@ void JACEA::TranspositionTable::clear_table()
         entry.flags = 0;
         entry.value = 0;
         entry.best_move = 0;
+        entry.age = 0;
     }
+    generation = 0;
 }
 
-int JACEA::TranspositionTable::read_hash_entry(const Position &pos, const int alpha, const int beta, const int depth) {
+int JACEA::TranspositionTable::read_hash_entry(const Position &pos, const int alpha, const int beta, const int depth, Move &best_move) {
     TTEntry& entry = hash_table[pos.get_key() % hash_table.size()];
 
     // Locks until is destructed from being out of scope
@@ -28,6 +30,8 @@ int JACEA::TranspositionTable::read_hash_entry(const Position &pos, const int al
 
     if (entry.key == pos.get_key())
     {
+        best_move = entry.best_move;
+
         if (entry.depth >= depth)
         {
             int score = entry.value;
@@ -58,21 +62,40 @@ int JACEA::TranspositionTable::read_hash_entry(const Position &pos, const int al
     return no_hash;
 }
 
-void JACEA::TranspositionTable::record_hash(const Position &pos, const int depth, int value, const int flag)
+void JACEA::TranspositionTable::record_hash(const Position &pos, const int depth, int value, const int flag, const Move best_move)
 {
     TTEntry& entry = hash_table[pos.get_key() % hash_table.size()];
 
     // Locks until is destructed from being out of scope
     std::lock_guard<std::mutex> guard(*entry.lock);
 
+    // Keep a clearly deeper entry of another position from this search, so the
+    // quiescence stores do not push the main search results out of the table
+    if (entry.key != pos.get_key() && entry.age == generation && entry.depth > depth + 2)
+        return;
+
+    // The same goes for a clearly deeper result of this very position, only an exact score replaces it.
+    // A new best move is still worth keeping for the move ordering
+    if (entry.key == pos.get_key() && entry.depth > depth + 2 && flag != flag_hash_exact)
+    {
+        if (best_move)
+            entry.best_move = best_move;
+        return;
+    }
+
     // If score is mating adjust for mate
     if (value > value_mate_lower)
         value += pos.get_ply();
     if (value < -value_mate_lower)
         value -= pos.get_ply();
 
+    // A fail low has no best move, keep the one found earlier for the same position
+    if (best_move || entry.key != pos.get_key())
+        entry.best_move = best_move;
+
     entry.key = pos.get_key();
     entry.depth = depth;
     entry.flags = flag;
     entry.value = value;
+    entry.age = generation;
 }
\ No newline at end of file
@@ -24,6 +24,7 @@ namespace JACEA
             int flags;
             int value;
             Move best_move;
+            int age; // generation of the search that stored the entry
             std::unique_ptr<std::mutex> lock = std::make_unique<std::mutex>();
         };
 
@@ -33,11 +34,16 @@ namespace JACEA
 
         void clear_table();
         void resize_table_mb(int size_mb);
+        // Call once per go, entries from older searches are replaced first
+        inline void new_search() { generation++; }
 
-        int read_hash_entry(const Position &pos, const int alpha, const int beta, const int depth);
+        // best_move is set to the stored move of the position even when the score can not be used
+        int read_hash_entry(const Position &pos, const int alpha, const int beta, const int depth, Move &best_move);
 
-        void record_hash(const Position &pos, const int depth, int value, const int flag);
+        // Quiescence stores with depth 0
+        void record_hash(const Position &pos, const int depth, int value, const int flag, const Move best_move);
     private:
         std::vector<TTEntry> hash_table;
+        int generation = 0;
     };
 }
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 #include <string>
+#include <cstdint>
 
 namespace JACEA
 {
@@ -7,9 +8,9 @@ namespace JACEA
     constexpr int max_game_depth = 64;
     constexpr int max_moves = 250;
 
-    typedef int Color;
+    typedef uint8_t Color;
 
-    enum eColor : int
+    enum eColor : uint8_t
     {
         WHITE,
         BLACK,
@@ -24,8 +25,8 @@ namespace JACEA
         bq = 0b1000
     };
 
-    typedef int Piece;
-    enum ePiece : int
+    typedef uint8_t Piece;
+    enum ePiece : uint8_t
     {
         P,
         N,
@@ -95,7 +96,7 @@ namespace JACEA
         return None;
     }
 
-    typedef int Move;
+    typedef uint16_t Move;
 
     /**
      * Evaluation
@@ -113,15 +114,11 @@ namespace JACEA
         500,
         900,
         12000};
-    struct ScoredMove
-    {
-        Move move;
-        int score = 0;
-    };
-
+    // Moves and their ordering scores live in separate arrays, scores[i] belongs to moves[i]
     struct MoveList
     {
-        ScoredMove moves[max_moves];
+        Move moves[max_moves];
+        int scores[max_moves];
         int size = 0;
     };
 
@@ -2,40 +2,77 @@
 #include "movegenerator.h"
 #include "utility.h"
 #include "search.h"
+#include "matesearch.h"
 #include <sstream>
 #include <iostream>
 #include <string>
 #include <filesystem>
-#include "nnue.h"
+#include <limits>
+#include <algorithm>
+#include "jacea_nnue.hpp"
 #include "tbprobe.h"
 
 using namespace JACEA;
 
-void JACEA::parse_setoption(TranspositionTable &tt, std::istringstream &tokenizer) {
-    std::string token;
+void JACEA::parse_setoption(TranspositionTable &tt, UCISettings &uci, std::istringstream &tokenizer) {
+    std::string token, name, value;
     tokenizer >> token;
-    if (token == "Hash")
+    if (token == "name")
+    {
+        // setoption name <id> [value <x>], both may contain spaces
+        while (tokenizer >> token && token != "value")
+            name += (name.empty() ? "" : " ") + token;
+        while (tokenizer >> token)
+            value += (value.empty() ? "" : " ") + token;
+    }
+    else
+    {
+        // Older form without the keywords, setoption <id> <x>
+        name = token;
+        tokenizer >> value;
+    }
+
+    if (name == "Hash")
     {
-        size_t hash_size_mb;
-        tokenizer >> hash_size_mb;
+        size_t hash_size_mb = std::stoul(value);
         tt.resize_table_mb(hash_size_mb);
         tt.clear_table();
     } 
-    else if (token == "SyzygyPath")
+    else if (name == "SyzygyPath")
     {
-        std::string syzygy_path;
-        tokenizer >> syzygy_path;
-        tb_init(std::filesystem::absolute(syzygy_path).generic_string().c_str());
+        tb_init(std::filesystem::absolute(value).generic_string().c_str());
     } 
-    else if (token == "NNUEPath")
+    else if (name == "SyzygyProbeDepth")
+    {
+        uci.syzygy_probe_depth = std::max(1, std::stoi(value));
+    }
+    else if (name == "SyzygyProbeLimit")
+    {
+        uci.syzygy_probe_limit = std::clamp(std::stoi(value), 0, 7);
+    }
+    else if (name == "NNUEPath")
+    {
+        load_nnue(value);
+    }
+    else if (name == "MultiPV")
     {
-        std::string nnue_file_path;
-        tokenizer >> nnue_file_path;
-        nnue_init(std::filesystem::absolute(nnue_file_path).generic_string().c_str());
+        uci.multi_pv = std::max(1, std::stoi(value));
+    }
+    else if (name == "Move Overhead")
+    {
+        uci.time_manager.move_overhead = std::stoi(value);
+    }
+    else if (name == "Threads")
+    {
+        uci.threads = std::max(1, std::stoi(value));
+    }
+    else if (name == "Deterministic")
+    {
+        uci.deterministic = value == "true";
     }
 }
 
-int JACEA::parse_move(Position &pos, const char *move_cstr)
+Move JACEA::parse_move(Position &pos, const char *move_cstr)
 {
     const int file_from = *move_cstr++ - 'a';
     const int rank_from = 8 - (*move_cstr++ - '0');
@@ -49,10 +86,10 @@ int JACEA::parse_move(Position &pos, const char *move_cstr)
     generate_moves(pos, ml);
     for (int i = 0; i < ml.size; i++)
     {
-        auto move = ml.moves[i].move;
+        const Move move = ml.moves[i];
         if (from_square == get_from_square(move) && to_square == get_to_square(move))
         {
-            if (*move_cstr != '\0')
+            if (*move_cstr != '\0' && is_promotion(move))
             {
                 auto promo_piece = get_promoted_piece(move);
                 if ((promo_piece == Q || promo_piece == q) && (*move_cstr == 'q' || *move_cstr == 'Q'))
@@ -74,88 +111,152 @@ int JACEA::parse_move(Position &pos, const char *move_cstr)
 void JACEA::parse_go(Position &pos, TranspositionTable &tt, UCISettings &uci, std::istringstream& tokenizer)
 {
     int max_depth = -1;
-    int increment = 0;
+    long long time_left = -1;
+    long long increment = 0;
+    long long move_time = -1;
+    int moves_to_go = 0;
+    int mate_moves = 0;
+    bool infinite = false;
 
     uci.stop = false;
-    uci.time_to_stop = -1;
-    int total_time = -1;
+    uci.ponder = false;
+    uci.search_moves.clear();
+    uci.node_limit = 0;
+    uci.mate_limit = 0;
+    bool reading_search_moves = false;
 
     std::string token;
     
     while (tokenizer >> token)
     {
+        // searchmoves takes every following token that is a move
+        if (reading_search_moves)
+        {
+            const Move move = token.size() >= 4 ? parse_move(pos, token.c_str()) : 0;
+            if (move)
+            {
+                uci.search_moves.push_back(move);
+                continue;
+            }
+            reading_search_moves = false;
+        }
+
         if (token == "wtime" && pos.get_side() == WHITE)
         {
             tokenizer >> token;
-            uci.time_to_stop = std::stoi(token);
+            time_left = std::stoll(token);
         }
         else if (token == "btime" && pos.get_side() == BLACK)
         {
             tokenizer >> token;
-            uci.time_to_stop = std::stoi(token);
+            time_left = std::stoll(token);
         }
         else if (token == "winc" && pos.get_side() == WHITE)
         {
             tokenizer >> token;
-            increment = std::stoi(token);
+            increment = std::stoll(token);
         }
         else if (token == "binc" && pos.get_side() == BLACK)
         {
             tokenizer >> token;
-            increment = std::stoi(token);
+            increment = std::stoll(token);
         }
         else if (token == "movetime")
         {
             tokenizer >> token;
-            total_time = std::stoi(token);
+            move_time = std::stoll(token);
         }
         else if (token == "movestogo")
         {
-            // uci.moves_to_go = std::stoi(split[i + 1]);
+            tokenizer >> token;
+            moves_to_go = std::stoi(token);
         }
         else if (token == "depth")
         {
             tokenizer >> token;
             max_depth = std::stoi(token);
         }
+        else if (token == "mate")
+        {
+            tokenizer >> token;
+            mate_moves = std::stoi(token);
+        }
+        else if (token == "nodes")
+        {
+            tokenizer >> token;
+            uci.node_limit = std::stoull(token);
+        }
         else if (token == "infinite")
         {
-            // uci.infinite = true;
+            infinite = true;
+        }
+        else if (token == "ponder")
+        {
+            uci.ponder = true;
+        }
+        else if (token == "searchmoves")
+        {
+            reading_search_moves = true;
         }
     }
 
-    if (max_depth < 0)
-        max_depth = max_game_depth;
-    // If time is -1 we did not recieve a time paramter so lets search for 10s
-    if (uci.time_to_stop < 0)
+    // A plain go without any limit still searches for 10s
+    const long long default_move_time = 10 * 1000;
+    if (!infinite && time_left < 0 && move_time <= 0 && max_depth < 0 && !uci.node_limit && mate_moves <= 0)
+        move_time = default_move_time;
+    if (infinite)
     {
-        uci.time_to_stop = 10 * 1000;
+        time_left = -1;
+        move_time = -1;
     }
-    else
+    // Mates that need a quiet move are left to the normal search, as deep as the mate can be
+    if (mate_moves > 0 && max_depth < 0)
+        max_depth = 2 * mate_moves;
+    if (max_depth < 0)
+        max_depth = max_game_depth;
+
+    const auto start_time = get_time_ms();
+    uci.time_manager.init(start_time, time_left, increment, moves_to_go, move_time);
+    uci.time_to_stop = uci.time_manager.is_limited() ? uci.time_manager.hard_deadline() : std::numeric_limits<long long>::max();
+
+    if (mate_moves > 0)
     {
-        // Save 100ms of our increment each turn to protect agaisnt
-        uci.time_to_stop += std::max(increment - 100, 0);
-        // Save another 100ms as margin to return our move
-        uci.time_to_stop -= 100;
-        if (uci.time_to_stop < 0)
-        {
-            uci.time_to_stop = 0;
-        }
-        else
+        std::cout << "Searching for a mate in " << mate_moves << std::endl;
+        if (search_mate(pos, uci, mate_moves))
+            return;
+
+        // The normal search gets what is left of the node budget. Without any limit it gets the 10s
+        // of a plain go, the depth alone does not bound it
+        uci.mate_limit = mate_moves;
+        if (uci.node_limit)
+            uci.node_limit = std::max<u64>(uci.node_limit - std::min<u64>(uci.total_nodes, uci.node_limit), 1);
+        else if (!infinite && !uci.time_manager.is_limited())
         {
-            uci.time_to_stop = std::min(10 * 1000ll, uci.time_to_stop / 20);
+            uci.time_manager.init(start_time, -1, 0, 0, default_move_time);
+            uci.time_to_stop = uci.time_manager.hard_deadline();
         }
     }
-    if (total_time > 0)
-    {
-        uci.time_to_stop = total_time;
-    }
-    std::cout << "Searching for: " << uci.time_to_stop << "ms"
-              << " to a max depth of " << max_depth << std::endl;
-    uci.time_to_stop += get_time_ms();
+
+    if (uci.time_manager.is_limited())
+        std::cout << "Searching for: " << uci.time_manager.get_optimum() << "ms (at most " << uci.time_manager.get_maximum() << "ms)"
+                  << " to a max depth of " << max_depth;
+    else
+        std::cout << "Searching without a time limit to a max depth of " << max_depth;
+    if (uci.node_limit)
+        std::cout << " and at most " << uci.node_limit << " nodes";
+    std::cout << std::endl;
     search(pos, tt, uci, max_depth);
 }
 
+void JACEA::ponderhit(UCISettings &uci)
+{
+    // The limits from the go command stay, only the time spent pondering no longer counts
+    uci.time_manager.restart(get_time_ms());
+    if (uci.time_manager.is_limited())
+        uci.time_to_stop = uci.time_manager.hard_deadline();
+    uci.ponder = false;
+}
+
 void JACEA::parse_position(Position &pos, std::istringstream &tokenizer)
 {
     std::string token;
@@ -1,27 +1,47 @@
 #pragma once
 #include "position.h"
 #include "transpositiontable.h"
+#include "timemanager.h"
 #include <sstream>
+#include <atomic>
+#include <vector>
 
 namespace JACEA
 {
     struct UCISettings
     {
-        u64 nodes = 0;
-        bool stop = false;
-        long long time_to_stop = -1;
-        int moves_to_go = 0;
-        bool completed_iteration = false;
-        bool stop_threads = false;
+        u64 nodes = 0; // Searched by the main thread
+        std::atomic<u64> total_nodes = 0; // Searched by all threads, each adds its nodes in batches
+        u64 node_limit = 0; // go nodes, 0 is no limit
+        std::atomic<u64> claimed_nodes = 0; // Handed out to the threads under a node limit, at least total_nodes
+        int mate_limit = 0; // go mate, the search ends once it finds a mate in at most this many moves, 0 is none
+        int threads = 5;
+        // Single threaded, and the hash table is cleared by every position command. A depth or node limited
+        // search after position is then reproducible, a repeated go without position reuses the table
+        bool deterministic = false;
+        // Written by the UCI thread and the search threads, read by all of them
+        std::atomic<bool> stop = false;
+        std::atomic<bool> ponder = false; // Searching on the opponent's time until ponderhit or stop
+        std::atomic<long long> time_to_stop = -1; // Hard deadline, the search is abandoned mid iteration past it
+        TimeManager time_manager;
+        std::atomic<bool> completed_iteration = false;
+        std::atomic<bool> stop_threads = false;
         int largest_depth = 0;
+        int multi_pv = 1;
+        std::vector<Move> search_moves; // go searchmoves, empty searches every move
         unsigned long long table_base_hits = 0;
+        int syzygy_probe_depth = 1; // Positions with exactly syzygy_probe_limit pieces are only probed from this depth on
+        int syzygy_probe_limit = 7; // Most pieces to probe with, the loaded tables may allow fewer
     };
 
-    void parse_setoption(TranspositionTable &tt, std::istringstream &tokenizer);
+    void parse_setoption(TranspositionTable &tt, UCISettings &uci, std::istringstream &tokenizer);
 
     void parse_position(Position &pos, std::istringstream &tokenizer);
 
     Move parse_move(Position &pos, const char *move_cstr);
 
+    // Switches a ponder search to a normal timed search, the clock starts now
+    void ponderhit(UCISettings &uci);
+
     void parse_go(Position &pos, TranspositionTable &tt, UCISettings &uci, std::istringstream& tokenizer);
 }
\ No newline at end of file
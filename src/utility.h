@@ -2,12 +2,16 @@
 #include <chrono>
 #include <vector>
 #include <string>
+#if defined(_MSC_VER)
+#include <stdlib.h>
+#endif
 
 namespace JACEA
 {
-    static inline auto get_time_ms()
+    // Monotonic, so clock adjustments by NTP can not move search deadlines
+    static inline long long get_time_ms()
     {
-        return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+        return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
     }
 
     // https://stackoverflow.com/questions/14265581/parse-split-a-string-in-c-using-string-delimiter-standard-c
@@ -28,8 +32,14 @@ namespace JACEA
         return tokens;
     }
 
+    // Flips a board vertically, a single instruction where the compiler has an intrinsic for it
     static inline unsigned long long bswap64(unsigned long long x)
     {
+#if defined(__GNUC__) || defined(__clang__)
+        return __builtin_bswap64(x);
+#elif defined(_MSC_VER)
+        return _byteswap_uint64(x);
+#else
         return ((x & 0xff00000000000000ull) >> 56) |
                ((x & 0x00ff000000000000ull) >> 40) |
                ((x & 0x0000ff0000000000ull) >> 24) |
@@ -38,5 +48,6 @@ namespace JACEA
                ((x & 0x0000000000ff0000ull) << 24) |
                ((x & 0x000000000000ff00ull) << 40) |
                ((x & 0x00000000000000ffull) << 56);
+#endif
     }
 }